@@ -2,55 +2,67 @@
 #include "asm_data.h"
 #include "asm_utils.h"
 #include "asm_handlers.h"
+#include "asm_regalloc.h"
 
 #include "../symbols/symbols.h"
+#include "../passes/passes.h"
+#include "../context/context.h"
 
 #include <iostream>
+#include <mutex>
+#include <vector>
+
+// Code of one function, and of the global TACs before it, into the buffer of the function
+static void generateFunction(FunctionContext& function) {
+    AsmBuffer& out = function.assembly;
+    const PassFlags& passes = function.unit.passes;
+    int LCcounter = function.firstLocalLabel;
+    Symbol* currentFunc = nullptr;
+    std::vector<int> savedRegs;
+    std::unordered_set<TAC*> fusedBranches;
+    VectorBases vectorBases;
+    std::unordered_set<Symbol*> loopHeaders;
+    StagedArgs stagedArgs;
+
+    TAC* code = function.code.head;
 
-std::string generateAsm(TAC* code) {
-    std::ostringstream oss;
-    std::ostringstream dataOss;
-    int LCcounter = 0;
-
-    // --- 1. Data Section ---
-    auto symbolTable = getSymbolTable();
-    generateDataSection(dataOss, symbolTable, LCcounter);
-    generateReadOnlyStrings(oss);
+    while(code) {
+        print_OriginalTAC(out, code);
 
-    // --- 2. Code Section ---
-    oss << "\t.text\n";
-    
-    code = goToTopTAC(code);
+        if(fusedBranches.count(code)) {
+            print_OriginalTAC(out, code->next);
+            handle_CmpBranch(out, code, code->next);
+            code = code->next->next;
+            continue;
+        }
 
-    while(code) {
-        print_OriginalTAC(oss, code);
         switch(code->type) {
             // ------------------
             // --- Arithmetic ---
             // ------------------
 
             case TACType::ADD: {
-                handle_BinOp(oss, code, "addl");
+                handle_BinOp(out, code, "addl");
                 break;
             }
             
             case TACType::SUB: {
-                handle_BinOp(oss, code, "subl");
+                handle_BinOp(out, code, "subl");
                 break;
             }
 
             case TACType::MUL: {
-                handle_Mul(oss, code);
+                handle_Mul(out, code);
                 break;
             }
 
             case TACType::DIV: {
-                handle_Div(oss, code);
+                handle_Div(out, code);
                 break;
             }
 
             case TACType::MOD: {
-                handle_Mod(oss, code);
+                handle_Mod(out, code);
                 break;
             }
 
@@ -59,56 +71,56 @@ std::string generateAsm(TAC* code) {
             // ------------------------
 
             case TACType::LESS: {
-                handle_Cmp(oss, code, "setg");
+                handle_Cmp(out, code, "setg");
                 break;
             }
 
             case TACType::GREATER: {
-                handle_Cmp(oss, code, "setl");
+                handle_Cmp(out, code, "setl");
                 break;
             }
 
             case TACType::LESSEQUAL: {
-                handle_Cmp(oss, code, "setge");
+                handle_Cmp(out, code, "setge");
                 break;
             }
 
             case TACType::GREATEREQUAL: {
-                handle_Cmp(oss, code, "setle");
+                handle_Cmp(out, code, "setle");
                 break;
             }
             
             case TACType::EQUAL: {
-                handle_Cmp(oss, code, "sete");
+                handle_Cmp(out, code, "sete");
                 break;
             }
 
             case TACType::NOTEQUAL: {
-                handle_Cmp(oss, code, "setne");
+                handle_Cmp(out, code, "setne");
                 break;
             }
 
             case TACType::AND: {
-                handle_And(oss, code, LCcounter);
+                handle_And(out, code, LCcounter);
                 break;
             }
 
             case TACType::OR: {
-                handle_Or(oss, code, LCcounter);
+                handle_Or(out, code, LCcounter);
                 break;
             }
 
             case TACType::NOT: {
-                handle_Not(oss, code);
+                handle_Not(out, code);
                 break;
             }
 
             case TACType::LSHIFT: {
-                handle_Shift(oss, code, true);
+                handle_Shift(out, code, true);
                 break;
             }
             case TACType::RSHIFT: {
-                handle_Shift(oss, code, false);
+                handle_Shift(out, code, false);
                 break;
             }
 
@@ -118,42 +130,57 @@ std::string generateAsm(TAC* code) {
 
 
             case TACType::LABEL: {
-                handle_Label(oss, code);
+                // Loop header, the vector addresses it uses are loaded on the way in
+                for(auto& load : vectorBases.loads[code])
+                    out << "\tleaq\t" << load.first->content << "(%rip), " << load.second << "\n";
+
+                // Same alignment gcc gives to loops, unless it costs more than 10 bytes of padding
+                if(loopHeaders.count(code->res))
+                    out << "\t.p2align 4,,10\n";
+
+                handle_Label(out, code);
                 break;
             }
 
             case TACType::JUMP: {
-                handle_Jump(oss, code);
+                handle_Jump(out, code);
                 break;
             }
 
             case TACType::IFZ: {
-                handle_IfZ(oss, code);
+                handle_IfZ(out, code);
                 break;
             }
     
             case TACType::BEGINFUN: {
-                handle_BeginFun(oss, code);
+                currentFunc = code->res;
+                function.registers.clear();
+                savedRegs = passes.regalloc ? allocateRegisters(code, function.registers) : std::vector<int>();
+                fusedBranches = passes.fuseBranches ? findFusedBranches(code) : std::unordered_set<TAC*>();
+                vectorBases = passes.vectorBases ? assignVectorBases(code) : VectorBases();
+                loopHeaders = passes.alignLoops ? findLoopHeaders(code) : std::unordered_set<Symbol*>();
+                stagedArgs = findStagedArgs(code);
+                handle_BeginFun(out, code, savedRegs);
                 break;
             }
 
             case TACType::ENDFUN: {
-                handle_EndFun(oss, code);
+                handle_EndFun(out, code, savedRegs);
                 break;
             }
 
             case TACType::RET: {              
-                handle_Return(oss, code);
+                handle_Return(out, code, currentFunc);
                 break;
             }
 
             case TACType::CALL: {
-                handle_Call(oss, code);
+                handle_Call(out, code, stagedArgs);
                 break;
             }
 
             case TACType::ARG: {
-                handle_Arg(oss, code);
+                handle_Arg(out, code, stagedArgs);
                 break;
             }
 
@@ -162,27 +189,27 @@ std::string generateAsm(TAC* code) {
             // --------------------
 
             case TACType::MOVE: {
-                handle_Move(oss, code);
+                handle_Move(out, code);
                 break;
             }
 
             case TACType::READ: {
-                handle_Read(oss, code);
+                handle_Read(out, code);
                 break;
             }
 
             case TACType::PRINT: {
-                handle_Print(oss, code, LCcounter);
+                handle_Print(out, code, LCcounter);
                 break;
             }	
 
             case TACType::MOVEVEC: {
-                handle_Move(oss, code);
+                handle_Move(out, code, vectorBases.baseReg[code]);
                 break;
             }
 
             case TACType::VECACCESS: {
-                handle_Move(oss, code);
+                handle_Move(out, code, vectorBases.baseReg[code]);
                 break;
             }
 
@@ -192,11 +219,58 @@ std::string generateAsm(TAC* code) {
 
         code = code->next;
     }
+}
 
-    generateTemp(dataOss, symbolTable);
+void generateAsm(TACList& list, std::ostream& file) {
+    CompilationContext& ctx = context();
+    int LCcounter = 0;
 
-    // Security end of file info
-    generateFileEpilogue(oss);
+    // --- 1. Data Section ---
+    std::vector<Symbol*> symbols = getAllSymbols();
+    generateDataSection(file, symbols, LCcounter);
+    generateReadOnlyStrings(file);
+
+    // --- 2. Code Section ---
+    file << "\t.text\n";
+
+    // Each function is emitted on its own (forEachFunction), the labels it takes are counted beforehand so they
+    // get the same numbers they would with the functions emitted in order
+    splitFunctions(list);
+
+    for(auto& function : ctx.functions) {
+        function->firstLocalLabel = LCcounter;
+
+        for(TAC* t = function->code.head; t; t = t->next)
+            LCcounter += localLabelCount(t);
+    }
+
+    // A function goes to the file as soon as it and the ones before it are done, only the buffers of the
+    // functions waiting for an earlier one stay in memory
+    std::mutex fileLock;
+    std::vector<bool> done(ctx.functions.size());
+    size_t written = 0;
+
+    forEachFunction([&](FunctionContext& function) {
+        generateFunction(function);
 
-    return dataOss.str() + oss.str();
-}
\ No newline at end of file
+        std::lock_guard<std::mutex> guard(fileLock);
+        done[function.index] = true;
+
+        for(; written < done.size() && done[written]; written++) {
+            FunctionContext& next = *ctx.functions[written];
+
+            file.write(next.assembly.data(), next.assembly.size());
+            file.flush();
+            next.assembly.release();
+            ctx.usedTemps.insert(next.usedTemps.begin(), next.usedTemps.end());
+        }
+    });
+
+    list = joinFunctions();
+
+    generateTemp(file, symbols);
+
+    // Security end of file info
+    generateFileEpilogue(file);
+    file.flush();
+}
@@ -5,6 +5,8 @@
 
 #include "../tacs/tacs.h"
 
-std::string generateAsm(TAC* code);
+// The whole file, streamed into file. The functions are emitted apart, on the pool of the unit when it has one
+// (context/context.h), and each one is written and flushed once the ones before it are
+void generateAsm(TACList& code, std::ostream& file);
 
 #endif /* ASM_COMP */
\ No newline at end of file
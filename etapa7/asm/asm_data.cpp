@@ -1,5 +1,6 @@
 #include "asm_data.h"
 #include "asm_utils.h"
+#include "../context/context.h"
 
 #include <cstring>      // For std::memcpy
 #include <cstdint>      // For uint32_t
@@ -9,14 +10,13 @@
 #include <algorithm>
 
 // Generates the entire data section by iterating the symbol table
-void generateDataSection(std::ostringstream& oss, std::map<std::string, Symbol*>& symbolTable, int& LCCounter) {
-    std::map<std::string, Symbol*>::iterator it;
+void generateDataSection(std::ostream& oss, const std::vector<Symbol*>& symbols, int& LCCounter) {
+    const AST& ast = context().ast;
 
     oss << "\t.text\n\t.section\t.data\n";
 
     // Print asm of the variables and constants
-    for (it = symbolTable.begin(); it != symbolTable.end(); it++) {
-        Symbol* symbol = it->second;
+    for (Symbol* symbol : symbols) {
 
         switch (symbol->symType) {
             case SymbolType::String:{ 
@@ -30,53 +30,53 @@ void generateDataSection(std::ostringstream& oss, std::map<std::string, Symbol*>
             }
 
             case SymbolType::VarId: {
-                if(!symbol->value)
+                if(symbol->value == NoNode)
                     break;
 
-                std::string size = std::to_string(dataSizeTable[symbol->dataType]);
+                std::string size = std::to_string(dataSizeTable.at(symbol->dataType));
 
                 oss << "\t.globl\t" << symbol->content << "\n"
                 "\t.align 4\n"
                 "\t.type\t" << symbol->content << ", @object\n"
                 "\t.size\t" << symbol->content << ", " << size << "\n"
                 << symbol->content << ":\n"
-                << convertToAsm(symbol->value->symbol->content, symbol->value->symbol->dataType);
+                << convertToAsm(ast.symbol[symbol->value], ast.symbol[symbol->value]->dataType);
 
                 break;
             }
 
             case SymbolType::VecId: {
-                if(!symbol->value)
+                if(symbol->value == NoNode)
                     break;
 
-                unsigned long size = dataSizeTable[symbol->dataType];
+                unsigned long size = dataSizeTable.at(symbol->dataType);
+                Symbol* length = ast.symbol[ast.child(symbol->value, 0)];
 
                 oss << "\t.globl\t" << symbol->content << "\n"
                 "\t.align 4\n"
                 "\t.type\t" << symbol->content << ", @object\n"
-                "\t.size\t" << symbol->content << ", " << std::to_string(std::max(std::stoi(symbol->value->children[0]->symbol->content) * size, size)) << "\n"
+                "\t.size\t" << symbol->content << ", " << std::to_string(std::max(length->intValue * size, size)) << "\n"
                 << symbol->content << ":\n";
 
-                if(symbol->value->type != ASTNodeType::DecVarArray)
+                if(ast.type[symbol->value] != ASTNodeType::DecVarArray)
                     break;
 
                 // TODO: Talvez não der certo porque o char teria o tamanho byte enquanto que o int tem long
-                if(symbol->value->children[1])
-                    for(ASTNode* node = symbol->value->children[1]; node != nullptr; node = node->children[1]) {
-                        if(node->children[0] && node->children[0]->symbol)
-                        oss << convertToAsmConst(node->children[0]->symbol->content, node->children[0]->symbol->dataType, symbol->dataType);
-                    }
-                else if(symbol->value->children[0])
-                    oss << "\t.zero " << symbol->value->children[0]->symbol->content << "\n"; // TODO: Checa se o tamanho é só int ou não
+                ASTChildren init = ast.children(ast.child(symbol->value, 1));
+                if(!init.empty())
+                    for(ASTNodeId element : init)
+                        oss << convertToAsmConst(ast.symbol[element], ast.symbol[element]->dataType, symbol->dataType);
+                else
+                    oss << "\t.zero " << length->intValue * size << "\n";
 
                 break;
             }
 
             case SymbolType::Float: {
-                if(symbol->value == nullptr) {
+                if(symbol->value == NoNode) {
                     symbol->label = ".LC" + std::to_string(LCCounter);
 
-                    oss << symbol->label + ":\n" << convertToAsm(symbol->content, DataType::Real);
+                    oss << symbol->label + ":\n" << convertToAsm(symbol, DataType::Real);
 
                     LCCounter++;
                 }
@@ -89,11 +89,12 @@ void generateDataSection(std::ostringstream& oss, std::map<std::string, Symbol*>
     }
 }
 
-void generateTemp(std::ostringstream& oss, std::map<std::string, Symbol*>& symbolTable) {
-    std::map<std::string, Symbol*>::iterator it;
+void generateTemp(std::ostream& oss, const std::vector<Symbol*>& symbols) {
+    const std::map<Symbol*, bool>& usedTemps = context().usedTemps;
 
-    for (it = symbolTable.begin(); it != symbolTable.end(); it++) {
-        Symbol* symbol = it->second;
+    oss << "\n\t.section\t.data\n";
+
+    for (Symbol* symbol : symbols) {
 
         switch (symbol->symType) {
             case SymbolType::Temp: {
@@ -118,7 +119,7 @@ void generateTemp(std::ostringstream& oss, std::map<std::string, Symbol*>& symbo
 
 
 // Generates the .rodata strings (like "%d", "true", etc.)
-void generateReadOnlyStrings(std::ostringstream& oss) {
+void generateReadOnlyStrings(std::ostream& oss) {
     oss <<  "\n\t.section\t.rodata\n"
             "._print_s:\n"
             "\t.string\t\"%s\"\n"
@@ -135,34 +136,32 @@ void generateReadOnlyStrings(std::ostringstream& oss) {
 }
 
 // Helper for data generation
-std::string convertToAsm(const std::string& valueString, DataType dataType) {
+std::string convertToAsm(const Symbol* literal, DataType dataType) {
     std::ostringstream oss;
 
     switch (dataType) {
         case DataType::Char: {
-            // Get the ASCII value of the first character
-            int asciiValue = static_cast<int>(valueString[1]);
+            // ASCII value of the character
+            int asciiValue = literal->intValue;
             oss << "\t.byte\t" << asciiValue;
             break;
         }
 
         case DataType::Bool: {
-            // Convert "true" to 1, otherwise 0
-            int boolValue = (valueString == "true") ? 1 : 0;
+            // 1 for true, 0 for false
+            int boolValue = literal->intValue;
             oss << "\t.byte\t" << boolValue;
             break;
         }
 
         case DataType::Int: {
-            // Parse the string as an integer
-            // stoi will handle parsing "50" to 50
-            oss << "\t.long\t" << std::stoi(valueString);
+            oss << "\t.long\t" << literal->intValue;
             break;
         }
 
         case DataType::Real: {
-            // Parse to float, then get its 32-bit integer bit-pattern
-            float floatValue = std::stof(valueString);
+            // 32-bit integer bit-pattern of the float
+            float floatValue = literal->floatValue;
             uint32_t intRepresentation;
 
             // Ensure float is 32-bit on this platform
@@ -185,7 +184,7 @@ std::string convertToAsm(const std::string& valueString, DataType dataType) {
     return oss.str() + '\n';
 };
 
-std::string convertToAsmConst(const std::string& valueString, DataType dataType, DataType typeVar) {
+std::string convertToAsmConst(const Symbol* literal, DataType dataType, DataType typeVar) {
     std::ostringstream oss;
 
     switch (typeVar) {
@@ -211,29 +210,27 @@ std::string convertToAsmConst(const std::string& valueString, DataType dataType,
 
     switch (dataType) {
         case DataType::Char: {
-            // Get the ASCII value of the first character
-            int asciiValue = static_cast<int>(valueString[1]);
+            // ASCII value of the character
+            int asciiValue = literal->intValue;
             oss << asciiValue;
             break;
         }
 
         case DataType::Bool: {
-            // Convert "true" to 1, otherwise 0
-            int boolValue = (valueString == "true") ? 1 : 0;
+            // 1 for true, 0 for false
+            int boolValue = literal->intValue;
             oss << boolValue;
             break;
         }
 
         case DataType::Int: {
-            // Parse the string as an integer
-            // stoi will handle parsing "50" to 50
-            oss << std::stoi(valueString);
+            oss << literal->intValue;
             break;
         }
 
         case DataType::Real: {
-            // Parse to float, then get its 32-bit integer bit-pattern
-            float floatValue = std::stof(valueString);
+            // 32-bit integer bit-pattern of the float
+            float floatValue = literal->floatValue;
             uint32_t intRepresentation;
 
             // Ensure float is 32-bit on this platform
@@ -257,7 +254,7 @@ std::string convertToAsmConst(const std::string& valueString, DataType dataType,
 };
 
 
-void generateFileEpilogue(std::ostringstream& oss) {
+void generateFileEpilogue(std::ostream& oss) {
     oss <<  "\n# FILE SECURITY DETAIL\n"
             "\t.ident\t\"GCC: (Ubuntu 13.3.0-6ubuntu2~24.04) 13.3.0\"\n"
             "\t.section\t.note.GNU-stack,\"\",@progbits\n"
@@ -7,19 +7,20 @@
 #include <string>
 
 // Generates the entire data section by iterating the symbol table
-void generateDataSection(std::ostringstream& oss, 
-                         std::map<std::string, Symbol*>& symbolTable, 
+void generateDataSection(std::ostream& oss, 
+                         const std::vector<Symbol*>& symbols, 
                          int& LCCounter);
 
-void generateTemp(std::ostringstream& oss, std::map<std::string, Symbol*>& symbolTable);
+// Slots of the temps the code left in memory, in .data again after the code: they are only known once it is emitted
+void generateTemp(std::ostream& oss, const std::vector<Symbol*>& symbols);
 
 // Generates the .rodata strings (like "%d", "true", etc.)
-void generateReadOnlyStrings(std::ostringstream& oss);
+void generateReadOnlyStrings(std::ostream& oss);
 
-void generateFileEpilogue(std::ostringstream& oss);
+void generateFileEpilogue(std::ostream& oss);
 
 // Helper for data generation
-std::string convertToAsm(const std::string& valueString, DataType dataType);
-std::string convertToAsmConst(const std::string& valueString, DataType dataType, DataType typeVar);
+std::string convertToAsm(const Symbol* literal, DataType dataType);
+std::string convertToAsmConst(const Symbol* literal, DataType dataType, DataType typeVar);
 
 #endif /* ASM_DATA_COMP */
\ No newline at end of file
@@ -1,9 +1,20 @@
 #include "asm_handlers.h"
 #include "asm_utils.h" // For symbolToAsm, getAsmDestination
+#include "../passes/passes.h"
+#include "../context/context.h"
 #include <stdexcept> // For runtime_error
 
+// Local label .L<number> taken from LCCounter, written without building its name
+struct LocalLabel {
+    int number;
+};
+
+static AsmBuffer& operator<<(AsmBuffer& out, LocalLabel label) {
+    return out << ".L" << label.number;
+}
+
 // --- Arithmetic Handlers ---
-void handle_BinOp(std::ostringstream& oss, TAC* code, const std::string& instruction) {
+void handle_BinOp(AsmBuffer& out, TAC* code, std::string_view instruction) {
     // Handle op1 (Load into %eax)
     bool op1_already_in_eax =  (code->prev && 
                                 reusableResEax.count(code->prev->type) && 
@@ -11,57 +22,160 @@ void handle_BinOp(std::ostringstream& oss, TAC* code, const std::string& instruc
 
     if (!op1_already_in_eax) {
         // If not, we must load it.
-        oss << "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n";
+        out << "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n";
     }
 
     // Handle op2 (Load into %edx)
-    oss << "\tmovl\t" << symbolToAsm(code->op2) << ", %edx\n";
+    out << "\tmovl\t" << symbolToAsm(code->op2) << ", %edx\n";
 
-    oss << "\t" << instruction << "\t%edx, %eax\n";
+    out << "\t" << instruction << "\t%edx, %eax\n";
 
-    oss << "\tmovl\t%eax, " << getAsmDestination(code->res) << "\n";
+    out << "\tmovl\t%eax, " << getAsmDestination(code->res) << "\n";
 }
 
-void handle_Mul(std::ostringstream& oss, TAC* code) {
+void handle_Mul(AsmBuffer& out, TAC* code) {
     if (code->op1->symType == SymbolType::Integer && code->op2->symType == SymbolType::Integer) {
-        oss << "\tmovl\t$" << (std::stoi(code->op1->content) * std::stoi(code->op2->content)) 
+        out << "\tmovl\t$" << (code->op1->intValue * code->op2->intValue) 
             <<  ", %eax\n"
                 "\tmovl\t%eax, " << getAsmDestination(code->res) << "\n";
     } 
 
     // Case 1: op1 is constant
     else if (code->op1->symType == SymbolType::Integer) {
-        oss << "\tmovl\t" << symbolToAsm(code->op2) << ", %eax\n"
+        out << "\tmovl\t" << symbolToAsm(code->op2) << ", %eax\n"
             "\timull\t" << symbolToAsm(code->op1) << ", %eax, %eax\n"
             "\tmovl\t%eax, " << getAsmDestination(code->res) << "\n";
     }
 
     // Case 2: op2 is constant (imull is commutative)
     else if (code->op2->symType == SymbolType::Integer) {
-        oss << "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
+        out << "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
             "\timull\t" << symbolToAsm(code->op2) << ", %eax, %eax\n"
             "\tmovl\t%eax, " << getAsmDestination(code->res) << "\n";
     }
 
     // Case 3: Neither is constant
     else {
-        oss << "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
+        out << "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
             "\tmovl\t" << symbolToAsm(code->op2) << ", %edx\n"
             "\timull\t%edx, %eax\n"
             "\tmovl\t%eax, " << getAsmDestination(code->res) << "\n";
     }
 }
 
-void handle_Div(std::ostringstream& oss, TAC* code) {
-    oss <<  "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
+// Hacker's Delight, 10-1: multiplier and shift so that x / d == high 32 bits of (x * multiplier) >> shift, for d >= 2
+struct DivMagic {
+    int multiplier;
+    int shift;
+};
+
+static DivMagic signedDivMagic(unsigned d) {
+    const unsigned two31 = 0x80000000u;
+    unsigned anc = two31 - 1 - two31 % d;
+    unsigned q1 = two31 / anc, r1 = two31 - q1 * anc;
+    unsigned q2 = two31 / d, r2 = two31 - q2 * d;
+    unsigned delta;
+    int p = 31;
+
+    do {
+        p++;
+        q1 *= 2; r1 *= 2;
+        if(r1 >= anc) { q1++; r1 -= anc; }
+        q2 *= 2; r2 *= 2;
+        if(r2 >= d) { q2++; r2 -= d; }
+        delta = d - r2;
+    } while(q1 < delta || (q1 == delta && r1 == 0));
+
+    return {static_cast<int>(q2 + 1), p - 32};
+}
+
+static bool isConstantDivisor(Symbol* sym) {
+    return context().passes.divByConst && sym->symType == SymbolType::Integer && sym->intValue != 0;
+}
+
+// x / d without idivl, rounding towards zero. Leaves the quotient in %eax and x in %ecx
+static void emitDivByConstant(AsmBuffer& out, Symbol* x, int d) {
+    unsigned absD = d < 0 ? 0u - static_cast<unsigned>(d) : static_cast<unsigned>(d);
+
+    out << "\tmovl\t" << symbolToAsm(x) << ", %ecx\n";
+
+    if(absD == 1) {
+        out << "\tmovl\t%ecx, %eax\n";
+    } else if((absD & (absD - 1)) == 0) {
+        // Negative dividends get 2^k - 1 added first, so the shift rounds towards zero
+        int k = __builtin_ctz(absD);
+
+        out << "\tmovl\t%ecx, %eax\n";
+        if(k > 1)
+            out << "\tsarl\t$31, %eax\n";
+        out << "\tshrl\t$" << 32 - k << ", %eax\n"
+               "\taddl\t%ecx, %eax\n"
+               "\tsarl\t$" << k << ", %eax\n";
+    } else {
+        DivMagic magic = signedDivMagic(absD);
+
+        out << "\tmovl\t$" << magic.multiplier << ", %eax\n"
+               "\timull\t%ecx\n";
+        if(magic.multiplier < 0)
+            out << "\taddl\t%ecx, %edx\n";
+        if(magic.shift > 0)
+            out << "\tsarl\t$" << magic.shift << ", %edx\n";
+
+        // +1 when x is negative
+        out << "\tmovl\t%ecx, %eax\n"
+               "\tsarl\t$31, %eax\n"
+               "\tsubl\t%eax, %edx\n"
+               "\tmovl\t%edx, %eax\n";
+    }
+
+    if(d < 0)
+        out << "\tnegl\t%eax\n";
+}
+
+void handle_Div(AsmBuffer& out, TAC* code) {
+    if(isConstantDivisor(code->op2)) {
+        emitDivByConstant(out, code->op1, code->op2->intValue);
+        out << "\tmovl\t%eax, " << getAsmDestination(code->res) << "\n";
+        return;
+    }
+
+    out <<  "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
             "\tmovl\t" << symbolToAsm(code->op2) << ", %ecx\n"
             "\tcltd\n"
             "\tidivl\t%ecx\n"
             "\tmovl\t%eax, " << getAsmDestination(code->res) << "\n";
 }
 
-void handle_Mod(std::ostringstream& oss, TAC* code) {
-    oss <<  "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
+void handle_Mod(AsmBuffer& out, TAC* code) {
+    if(isConstantDivisor(code->op2)) {
+        int d = code->op2->intValue;
+        unsigned absD = d < 0 ? 0u - static_cast<unsigned>(d) : static_cast<unsigned>(d);
+
+        if(absD == 1) {
+            out << "\tmovl\t$0, %eax\n";
+        } else if((absD & (absD - 1)) == 0) {
+            // Mask of the low bits, with the same bias as the division so the result has the sign of x
+            int k = __builtin_ctz(absD);
+
+            out << "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
+                   "\tcltd\n"
+                   "\tshrl\t$" << 32 - k << ", %edx\n"
+                   "\taddl\t%edx, %eax\n"
+                   "\tandl\t$" << (absD - 1) << ", %eax\n"
+                   "\tsubl\t%edx, %eax\n";
+        } else {
+            // x - (x / d) * d
+            emitDivByConstant(out, code->op1, d);
+            out << "\timull\t$" << d << ", %eax, %eax\n"
+                   "\tsubl\t%eax, %ecx\n"
+                   "\tmovl\t%ecx, %eax\n";
+        }
+
+        out << "\tmovl\t%eax, " << getAsmDestination(code->res) << "\n";
+        return;
+    }
+
+    out <<  "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
             "\tmovl\t" << symbolToAsm(code->op2) << ", %esi\n"
             "\tcltd\n"
             "\tidivl\t%esi\n"
@@ -70,28 +184,42 @@ void handle_Mod(std::ostringstream& oss, TAC* code) {
             "\tmovl\t%eax, " << getAsmDestination(code->res) << "\n";
 }
 
-void handle_Shift(std::ostringstream& oss, TAC* code, bool toLeft) {
-    oss << "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
+void handle_Shift(AsmBuffer& out, TAC* code, bool toLeft) {
+    out << "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
            "\t" << (toLeft ? "sall" : "sarl") << "\t$" << code->op2->content << ", %eax\n"
            "\tmovl\t%eax, " << getAsmDestination(code->res) << "\n";
 }
 
 // --- Logic/Comparison Handlers ---
-void handle_Cmp(std::ostringstream& oss, TAC* code, const std::string& set_instruction) {
-    oss <<  "\tmovl\t" << symbolToAsm(code->op2) << ", %eax\n"
+void handle_Cmp(AsmBuffer& out, TAC* code, std::string_view set_instruction) {
+    out <<  "\tmovl\t" << symbolToAsm(code->op2) << ", %eax\n"
             "\tcmpl\t" << symbolToAsm(code->op1) << ", %eax\n"
             "\t" << set_instruction << "\t%al\n"
             "\tmovzbl\t%al, %eax\n"
-            "\tmovl\t%eax, " << code->res->content << "(%rip)\n";
+            "\tmovl\t%eax, " << getAsmDestination(code->res) << "\n";
+}
+
+int localLabelCount(TAC* code) {
+    switch(code->type) {
+        case TACType::AND:
+            return 2;
+
+        case TACType::OR:
+            return 3;
+
+        case TACType::PRINT:
+            return code->res->dataType == DataType::Bool ? 2 : 0;
+
+        default:
+            return 0;
+    }
 }
 
-void handle_And(std::ostringstream& oss, TAC* code, int& LCCounter) {
-    std::string labelPrint1 = ".L" + std::to_string(LCCounter);
-    LCCounter++;
-    std::string labelPrint2 = ".L" + std::to_string(LCCounter);
-    LCCounter++;
+void handle_And(AsmBuffer& out, TAC* code, int& LCCounter) {
+    LocalLabel labelPrint1{LCCounter++};
+    LocalLabel labelPrint2{LCCounter++};
 
-    oss <<  "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
+    out <<  "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
             "\ttestl\t%eax, %eax\n"
             "\tje\t" << labelPrint1 << "\n"
             "\tmovl\t" << symbolToAsm(code->op2) << ", %eax\n"
@@ -105,15 +233,12 @@ void handle_And(std::ostringstream& oss, TAC* code, int& LCCounter) {
             "\tmovl\t%eax, " << symbolToAsm(code->res) << "\n";
 }
 
-void handle_Or(std::ostringstream& oss, TAC* code, int& LCCounter) {
-    std::string labelPrint1 = ".L" + std::to_string(LCCounter);
-    LCCounter++;
-    std::string labelPrint2 = ".L" + std::to_string(LCCounter);
-    LCCounter++;
-    std::string labelPrint3 = ".L" + std::to_string(LCCounter);
-    LCCounter++;
+void handle_Or(AsmBuffer& out, TAC* code, int& LCCounter) {
+    LocalLabel labelPrint1{LCCounter++};
+    LocalLabel labelPrint2{LCCounter++};
+    LocalLabel labelPrint3{LCCounter++};
 
-    oss <<  "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
+    out <<  "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
             "\ttestl\t%eax, %eax\n"
             "\tjne\t" << labelPrint1 << "\n"
             "\tmovl\t" << symbolToAsm(code->op2) << ", %eax\n"
@@ -128,8 +253,8 @@ void handle_Or(std::ostringstream& oss, TAC* code, int& LCCounter) {
             "\tmovl\t%eax, " << symbolToAsm(code->res) << "\n";
 }
 
-void handle_Not(std::ostringstream& oss, TAC* code) {
-    oss <<  "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
+void handle_Not(AsmBuffer& out, TAC* code) {
+    out <<  "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
             "\ttestl\t%eax, %eax\n"
             "\tsete\t%al\n"
             "\tmovzbl\t%al, %eax\n"
@@ -137,58 +262,72 @@ void handle_Not(std::ostringstream& oss, TAC* code) {
 }
 
 // --- Control Flow Handlers ---
-void handle_Label(std::ostringstream& oss, TAC* code) {
-    oss << code->res->content << ":\n";
+void handle_Label(AsmBuffer& out, TAC* code) {
+    out << code->res->content << ":\n";
 }
 
-void handle_Jump(std::ostringstream& oss, TAC* code) {
-    oss << "\tjmp\t" << code->res->content << "\n";
+void handle_Jump(AsmBuffer& out, TAC* code) {
+    out << "\tjmp\t" << code->res->content << "\n";
 }
 
-void handle_IfZ(std::ostringstream& oss, TAC* code)  {
-    oss <<  "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
+void handle_IfZ(AsmBuffer& out, TAC* code)  {
+    if(inRegister(code->op1)) {
+        out <<  "\ttestl\t" << symbolToAsm(code->op1) << ", " << symbolToAsm(code->op1) << "\n"
+                "\tjz\t" << code->res->content << "\n";
+        return;
+    }
+
+    out <<  "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n"
             "\ttestl\t%eax, %eax\n"
             "\tjz\t" << code->res->content << "\n";
 }
 
-void handle_BeginFun(std::ostringstream& oss, TAC* code) {
-    int stackSize = 0;
-    int value = -4;
-    std::vector<Symbol*> locals;
-    if(code->res->params.size() > 0) {
-        stackSize = code->res->params.size() * 4;
-
-        for(size_t i = 0; i < code->res->params.size(); i++) {
-            code->res->params[i]->content = std::to_string(value);
-            value -= 4;
-
-            locals.push_back(code->res->params[i]);
-        }
+// Comparison followed by the IFZ that reads it, jumps when the comparison is false
+void handle_CmpBranch(AsmBuffer& out, TAC* code, TAC* ifz) {
+    static const std::map<TACType, std::string_view> jumpIfFalse = {
+        {TACType::LESS, "jge"},
+        {TACType::GREATER, "jle"},
+        {TACType::LESSEQUAL, "jg"},
+        {TACType::GREATEREQUAL, "jl"},
+        {TACType::EQUAL, "jne"},
+        {TACType::NOTEQUAL, "je"},
+    };
+
+    Operand left = symbolToAsm(code->op1);
+
+    if(!inRegister(code->op1)) {
+        out << "\tmovl\t" << left << ", %eax\n";
+        left = Operand::reg("%eax");
     }
 
-    int i;
-    ASTNode* funct = code->res->value;
+    out <<  "\tcmpl\t" << symbolToAsm(code->op2) << ", " << left << "\n"
+            "\t" << jumpIfFalse.at(code->type) << "\t" << ifz->res->content << "\n";
+}
 
-    if(funct) {
-        for(i = 0; funct->children[i] && funct->children[i]->type != ASTNodeType::LocalVarDecList; i++);
+// Offset from %rbp of the slot that keeps the i-th saved callee register
+static int savedRegOffset(Symbol* func, size_t i) {
+    int localsSize = (getFrameSymbols(func).size() * 4 + 7) & ~7;
+    return -(localsSize + 8 * static_cast<int>(i + 1));
+}
 
-        if(funct->children[i]) {
-            for(ASTNode* node = funct->children[i]; node != nullptr; node = node->children[1]) {
-                if(node->children[0] && node->children[0]->symbol) {
-                    node->children[0]->symbol->content = std::to_string(value);
-                    value -= 4;
-                    stackSize += 4;
+void handle_BeginFun(AsmBuffer& out, TAC* code, const std::vector<int>& savedRegs) {
+    const AST& ast = context().ast;
+    std::unordered_map<Symbol*, int>& frameOffsets = currentFunction()->frameOffsets;
+    int value = -4;
+    std::vector<Symbol*> locals = getFrameSymbols(code->res);
 
-                    locals.push_back(node->children[0]->symbol);
-                }
-            }
-        }
+    frameOffsets.clear();
+    for(Symbol* local : locals) {
+        frameOffsets[local] = value;
+        value -= 4;
     }
 
+    int stackSize = -savedRegOffset(code->res, savedRegs.size()) - 8;
+
     // Aligns it to 16
     stackSize = (stackSize + 15) & ~15;
 
-    oss <<  "\t.text\n"
+    out <<  "\t.text\n"
             "\t.globl\t" << code->res->content << "\n"
             "\t.type\t" << code->res->content << ", @function\n"
             << code->res->content << ":\n"
@@ -198,47 +337,100 @@ void handle_BeginFun(std::ostringstream& oss, TAC* code) {
     
     // Initialize stack
     if(stackSize > 0)
-        oss << "\tsubq\t$" << std::to_string(stackSize) << ", %rsp\n";
+        out << "\tsubq\t$" << stackSize << ", %rsp\n";
+
+    for (size_t i = 0; i < savedRegs.size(); i++)
+        out << "\tmovq\t" << allocatableRegs64[savedRegs[i]] << ", " << savedRegOffset(code->res, i) << "(%rbp)\n";
 
     // Initialize all local variables
     for (size_t i = 0; i < locals.size(); i++) {
         if(locals[i]->symType == SymbolType::Local) {
+            if(locals[i]->value == NoNode)
+                continue; // Created by the optimizer, starts undefined
+
             // TODO: The value should be different
-            oss << "\tmovl\t$" << locals[i]->value->symbol->content << ", " << symbolToAsm(locals[i]) << "\n";
+            out << "\tmovl\t$" << ast.symbol[locals[i]->value]->content << ", " << symbolToAsm(locals[i]) << "\n";
         } else {
             int index = code->res->getParamIndex(locals[i]);
             if(index >= 0)
-                oss << "\tmovl\t" << argumentLoc[index] << ", " << symbolToAsm(locals[i]) << "\n";
+                out << "\tmovl\t" << argumentLoc[index] << ", " << symbolToAsm(locals[i]) << "\n";
         }
     }
     
 }
 
-void handle_EndFun(std::ostringstream& oss, TAC* code) {
-    oss <<  "\tmovq\t%rbp, %rsp\n"
+void handle_EndFun(AsmBuffer& out, TAC* code, const std::vector<int>& savedRegs) {
+    // Reached the end without a return, returns 0 like main in C
+    if(code->prev && code->prev->type != TACType::RET && code->prev->type != TACType::JUMP)
+        out << "\tmovl\t$0, %eax\n";
+
+    out << ".Lret_" << code->res->content << ":\n";
+
+    for (size_t i = 0; i < savedRegs.size(); i++)
+        out << "\tmovq\t" << savedRegOffset(code->res, i) << "(%rbp), " << allocatableRegs64[savedRegs[i]] << "\n";
+
+    out <<  "\tmovq\t%rbp, %rsp\n"
             "\tpopq\t%rbp\n"
             "\tret\n"
             "\t.size\t" << code->res->content << ", .-" << code->res->content << "\n";
 }
 
-void handle_Return(std::ostringstream& oss, TAC* code) {
-    if(!(code->prev && code->prev->res == code->res))
-        oss << "\tmovl\t" << symbolToAsm(code->res) << ", %eax\n"; 
+void handle_Return(AsmBuffer& out, TAC* code, Symbol* func) {
+    bool res_already_in_eax =  (code->prev && 
+                                reusableResEax.count(code->prev->type) && 
+                                code->prev->res == code->res);
+
+    if(!res_already_in_eax)
+        out << "\tmovl\t" << symbolToAsm(code->res) << ", %eax\n"; 
+
+    // Goes to the epilogue, unless it is right after this
+    if(!(code->next && code->next->type == TACType::ENDFUN))
+        out << "\tjmp\t.Lret_" << func->content << "\n";
 }
 
-void handle_Call(std::ostringstream& oss, TAC* code) {
-    oss <<  "\tcall\t" << code->op1->content << "\n"
+void handle_Call(AsmBuffer& out, TAC* code, const StagedArgs& staged) {
+    // The staged ARGs of the call are the last ones pushed, the last of them on top
+    auto it = staged.calls.find(code);
+    if(it != staged.calls.end()) {
+        const std::vector<int>& indexes = it->second;
+
+        for(size_t i = 0; i < indexes.size(); i++) {
+            long slot = 16 * static_cast<long>(indexes.size() - 1 - i);
+            out << "\tmovl\t" << Operand::memory(slot, "", "%rsp") << ", " << argumentLoc[indexes[i]] << "\n";
+        }
+
+        out << "\taddq\t$" << 16 * indexes.size() << ", %rsp\n";
+    }
+
+    out <<  "\tcall\t" << code->op1->content << "\n"
             "\tmovl\t%eax, " << symbolToAsm(code->res) << "\n";
 }
 
-void handle_Arg(std::ostringstream& oss, TAC* code) {    
+void handle_Arg(AsmBuffer& out, TAC* code, const StagedArgs& staged) {
     int index = code->res->getParamIndex(code->op2);
-    if(index >= 0)
-        oss << "\tmovl\t" << symbolToAsm(code->op1) << ", " << argumentLoc[index] << "\n";
+    if(index < 0)
+        return;
+
+    Operand value = symbolToAsm(code->op1);
+
+    if(!staged.args.count(code)) {
+        out << "\tmovl\t" << value << ", " << argumentLoc[index] << "\n";
+        return;
+    }
+
+    // 16 bytes, so the calls made before the CALL still find the stack aligned
+    out << "\tsubq\t$16, %rsp\n";
+
+    if(value.kind == Operand::Kind::Memory) {
+        out << "\tmovl\t" << value << ", %eax\n";
+        value = Operand::reg("%eax");
+    }
+
+    out << "\tmovl\t" << value << ", (%rsp)\n";
 }
 
 // --- I/O and Move Handlers ---
-void handle_Move(std::ostringstream& oss, TAC* code) {
+void handle_Move(AsmBuffer& out, TAC* code, const std::string& baseReg) {
     Symbol* src = nullptr;
     Symbol* dst = nullptr;
     int index = -1;
@@ -251,31 +443,9 @@ void handle_Move(std::ostringstream& oss, TAC* code) {
             break;
 
         case TACType::MOVEVEC:
-            src = code->op2;
-            dst = code->res;
-            
-            if(memorySym.count(code->op1->symType)) {
-                oss << "\tmovl\t" << code->op1->content << "(%rip), %eax\n" <<
-                       "\tcltq\n" <<
-                       "\tleaq\t0(,%rax,4), %rdx\n" <<
-                       "\tleaq\t" << src->content << "(%rip), %rax\n";
-            } else
-                index = std::stoi(code->op1->content);
-
-            break;
-
         case TACType::VECACCESS:
             src = code->op2;
             dst = code->res;
-            
-            if(memorySym.count(code->op1->symType)) {
-                oss << "\tmovl\t" << code->op1->content << "(%rip), %eax\n" <<
-                       "\tcltq\n" <<
-                       "\tleaq\t0(,%rax,4), %rdx\n" <<
-                       "\tleaq\t" << src->content << "(%rip), %rax\n";
-            } else
-                index = std::stoi(code->op1->content);
-
             break;
         
         default:
@@ -285,16 +455,45 @@ void handle_Move(std::ostringstream& oss, TAC* code) {
     if(src == nullptr || dst == nullptr)
         throw std::runtime_error("Invalide move instruction.");
 
-    if(memorySym.count(src->symType)) {
-        oss << 
-            "\tmovl\t" << symbolToAsm(src, index) << ", %eax\n"
-            "\tmovl\t%eax, " << getAsmDestination(dst, index) << "\n";
+    Operand from, to;
+
+    if(code->type != TACType::MOVE) {
+        Symbol* vec = (code->type == TACType::MOVEVEC) ? dst : src;
+        Operand element;
+
+        if(!memorySym.count(code->op1->symType)) {
+            index = code->op1->intValue;
+            element = symbolToAsm(vec, index);
+        } else if(!baseReg.empty()) {
+            // The address of the vector was loaded before the loop
+            out << "\tmovslq\t" << symbolToAsm(code->op1) << ", %rax\n";
+            element = Operand::indexed(baseReg, "%rax", 4);
+        } else {
+            out << "\tmovl\t" << symbolToAsm(code->op1) << ", %eax\n" <<
+                   "\tcltq\n" <<
+                   "\tleaq\t0(,%rax,4), %rdx\n" <<
+                   "\tleaq\t" << vec->content << "(%rip), %rax\n";
+            element = Operand::indexed("%rdx", "%rax");
+        }
+
+        from = (code->type == TACType::MOVEVEC) ? symbolToAsm(src) : element;
+        to = (code->type == TACType::MOVEVEC) ? element : getAsmDestination(dst);
+    } else {
+        from = symbolToAsm(src, index);
+        to = getAsmDestination(dst, index);
+    }
+
+    // %rax may be holding the vector address, so the value goes through %ecx
+    if(memorySym.count(src->symType) && !inRegister(src) && !inRegister(dst)) {
+        out << 
+            "\tmovl\t" << from << ", %ecx\n"
+            "\tmovl\t%ecx, " << to << "\n";
     } else
-        oss << "\tmovl\t" << symbolToAsm(src, index) << ", " << getAsmDestination(dst, index) << "\n";
+        out << "\tmovl\t" << from << ", " << to << "\n";
 }
 
-void handle_Read(std::ostringstream& oss, TAC* code) {
-    oss <<  "\tleaq\t" << symbolToAsm(code->res) << ", %rax\n"
+void handle_Read(AsmBuffer& out, TAC* code) {
+    out <<  "\tleaq\t" << symbolToAsm(code->res) << ", %rax\n"
             "\tmovq\t%rax, %rsi\n"
             "\tleaq\t._print_d(%rip), %rax\n"
             "\tmovq\t%rax, %rdi\n"
@@ -302,14 +501,14 @@ void handle_Read(std::ostringstream& oss, TAC* code) {
             "\tcall\t__isoc99_scanf@PLT\n";
 }
 
-void handle_Print(std::ostringstream& oss, TAC* code, int& LCCounter) {
+void handle_Print(AsmBuffer& out, TAC* code, int& LCCounter) {
     if(code->res->dataType == DataType::Bool) {
-        std::string labelPrint1 = ".L" + std::to_string(LCCounter);
-        LCCounter++;
-        std::string labelPrint2 = ".L" + std::to_string(LCCounter);
-        LCCounter++;
+        LocalLabel labelPrint1{LCCounter++};
+        LocalLabel labelPrint2{LCCounter++};
+
+        bool byteInMemory = memorySym.count(code->res->symType) && !inRegister(code->res);
 
-        oss <<  "\tmovzbl\t" << symbolToAsm(code->res) << ", %eax\n"
+        out <<  "\t" << (byteInMemory ? "movzbl" : "movl") << "\t" << symbolToAsm(code->res) << ", %eax\n"
                 "\ttestb\t%al, %al\n"
                 "\tje\t" << labelPrint1 << "\n"
                 "\tleaq\t.true(%rip), %rax\n"
@@ -324,38 +523,38 @@ void handle_Print(std::ostringstream& oss, TAC* code, int& LCCounter) {
     }
 
     if(code->res->symType == SymbolType::String) {
-        oss <<  "\tleaq\t" << symbolToAsm(code->res) << ", %rax\n"
+        out <<  "\tleaq\t" << symbolToAsm(code->res) << ", %rax\n"
                 "\tmovq\t%rax, %rdi\n"
                 "\tcall\tprintf@PLT\n";
 
         return;
     }
 
-    oss << "\tmovl\t" << symbolToAsm(code->res) << ", %esi\n";
+    out << "\tmovl\t" << symbolToAsm(code->res) << ", %esi\n";
 
-    oss << "\tleaq\t._print_";
+    out << "\tleaq\t._print_";
     switch(code->res->dataType) {
         case DataType::Int:
-            oss << "d";
+            out << "d";
             break;
 
         case DataType::Char:
-            oss << "c";
+            out << "c";
             break;
 
 
         case DataType::Real:
-            oss << "f";
+            out << "f";
             break;
 
         default:
-            oss << "d";
+            out << "d";
             break;
     }
 
-    oss << "(%rip), %rax\n";
+    out << "(%rip), %rax\n";
 
-    oss << "\tmovq\t%rax, %rdi\n"
+    out << "\tmovq\t%rax, %rdi\n"
             "\tmovl\t$0, %eax\n"
             "\tcall\tprintf@PLT\n";
 }
\ No newline at end of file
@@ -2,34 +2,44 @@
 #define ASM_HDL_COMP
 
 #include "../tacs/tacs.h"
-#include <sstream>
+#include "asm_writer.h"
+#include "asm_utils.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
 
 // --- Arithmetic Handlers ---
-void handle_BinOp(std::ostringstream& oss, TAC* code, const std::string& instruction);
-void handle_Mul(std::ostringstream& oss, TAC* code);
-void handle_Div(std::ostringstream& oss, TAC* code);
-void handle_Mod(std::ostringstream& oss, TAC* code);
-void handle_Shift(std::ostringstream& oss, TAC* code, bool toLeft);
+void handle_BinOp(AsmBuffer& out, TAC* code, std::string_view instruction);
+void handle_Mul(AsmBuffer& out, TAC* code);
+void handle_Div(AsmBuffer& out, TAC* code);
+void handle_Mod(AsmBuffer& out, TAC* code);
+void handle_Shift(AsmBuffer& out, TAC* code, bool toLeft);
+
+// .L labels the handler of code takes from LCCounter (And, Or and the Print of a bool), so each function
+// knows where its own labels start before the ones before it are emitted
+int localLabelCount(TAC* code);
 
 // --- Logic/Comparison Handlers ---
-void handle_Cmp(std::ostringstream& oss, TAC* code, const std::string& set_instruction);
-void handle_And(std::ostringstream& oss, TAC* code, int& LCCounter);
-void handle_Or(std::ostringstream& oss, TAC* code, int& LCCounter);
-void handle_Not(std::ostringstream& oss, TAC* code);
+void handle_Cmp(AsmBuffer& out, TAC* code, std::string_view set_instruction);
+void handle_And(AsmBuffer& out, TAC* code, int& LCCounter);
+void handle_Or(AsmBuffer& out, TAC* code, int& LCCounter);
+void handle_Not(AsmBuffer& out, TAC* code);
 
 // --- Control Flow Handlers ---
-void handle_Label(std::ostringstream& oss, TAC* code);
-void handle_Jump(std::ostringstream& oss, TAC* code);
-void handle_IfZ(std::ostringstream& oss, TAC* code);
-void handle_BeginFun(std::ostringstream& oss, TAC* code);
-void handle_EndFun(std::ostringstream& oss, TAC* code);
-void handle_Return(std::ostringstream& oss, TAC* code);
-void handle_Call(std::ostringstream& oss, TAC* code);
-void handle_Arg(std::ostringstream& oss, TAC* code);
+void handle_Label(AsmBuffer& out, TAC* code);
+void handle_Jump(AsmBuffer& out, TAC* code);
+void handle_IfZ(AsmBuffer& out, TAC* code);
+void handle_CmpBranch(AsmBuffer& out, TAC* code, TAC* ifz);
+void handle_BeginFun(AsmBuffer& out, TAC* code, const std::vector<int>& savedRegs);
+void handle_EndFun(AsmBuffer& out, TAC* code, const std::vector<int>& savedRegs);
+void handle_Return(AsmBuffer& out, TAC* code, Symbol* func);
+void handle_Call(AsmBuffer& out, TAC* code, const StagedArgs& staged);
+void handle_Arg(AsmBuffer& out, TAC* code, const StagedArgs& staged);
 
 // --- I/O and Move Handlers ---
-void handle_Move(std::ostringstream& oss, TAC* code);
-void handle_Read(std::ostringstream& oss, TAC* code);
-void handle_Print(std::ostringstream& oss, TAC* code, int& LCCounter);
+void handle_Move(AsmBuffer& out, TAC* code, const std::string& baseReg = ""); // baseReg: register holding the vector address
+void handle_Read(AsmBuffer& out, TAC* code);
+void handle_Print(AsmBuffer& out, TAC* code, int& LCCounter);
 
 #endif /* ASM_HDL_COMP */
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "asm_regalloc.h"
+#include "asm_utils.h"
+#include "../cfg/cfg.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+struct LiveInterval {
+    Symbol* sym;
+    int start;
+    int end;
+    bool crossesCall;
+    int order; // When the symbol was first seen, breaks the ties without looking at addresses
+    int reg;
+};
+
+// Only values that belong to the function can live in registers, globals are seen by everyone
+static bool isAllocatable(Symbol* sym) {
+    return sym && sym->isFunctionScoped();
+}
+
+// TACs that end up calling another function, which may trash the caller-saved registers
+static bool isCall(TAC* t) {
+    return t->type == TACType::CALL || t->type == TACType::PRINT || t->type == TACType::READ;
+}
+
+static void touch(std::map<Symbol*, LiveInterval>& intervals, Symbol* sym, int pos) {
+    auto it = intervals.find(sym);
+    if(it == intervals.end()) {
+        intervals[sym] = LiveInterval{sym, pos, pos, false, static_cast<int>(intervals.size()), -1};
+        return;
+    }
+
+    it->second.start = std::min(it->second.start, pos);
+    it->second.end = std::max(it->second.end, pos);
+}
+
+std::vector<int> allocateRegisters(TAC* beginFun, std::unordered_map<Symbol*, int>& registers) {
+    std::map<Symbol*, LiveInterval> intervals;
+    std::map<Symbol*, int> labelPos;
+    std::vector<std::pair<int, int>> backEdges; // (label, jump)
+    std::vector<int> calls;
+    std::set<Symbol*> addressTaken;
+
+    // Params and locals are written by the prologue, so they are alive since the start
+    for(Symbol* sym : getFrameSymbols(beginFun->res))
+        touch(intervals, sym, 0);
+
+    int pos = 1;
+    for(TAC* t = beginFun->next; t && t->type != TACType::ENDFUN; t = t->next, pos++) {
+        if(t->type == TACType::LABEL)
+            labelPos[t->res] = pos;
+
+        if(t->type == TACType::JUMP || t->type == TACType::IFZ) {
+            auto it = labelPos.find(t->res);
+            if(it != labelPos.end())
+                backEdges.push_back({it->second, pos});
+        }
+
+        if(isCall(t))
+            calls.push_back(pos);
+
+        // scanf needs the address of the variable
+        if(t->type == TACType::READ)
+            addressTaken.insert(t->res);
+
+        Symbol* def = tacDef(t);
+        if(isAllocatable(def))
+            touch(intervals, def, pos);
+
+        for(Symbol* use : tacUses(t))
+            if(isAllocatable(use))
+                touch(intervals, use, pos);
+    }
+
+    // Whatever is alive when entering a loop has to survive the whole loop
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(auto& entry : intervals) {
+            LiveInterval& it = entry.second;
+            for(auto& edge : backEdges) {
+                if(it.start < edge.first && it.end >= edge.first && it.end < edge.second) {
+                    it.end = edge.second;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    std::vector<LiveInterval*> sorted;
+    for(auto& entry : intervals) {
+        LiveInterval& it = entry.second;
+
+        if(addressTaken.count(it.sym))
+            continue;
+
+        for(int c : calls)
+            if(it.start < c && c < it.end)
+                it.crossesCall = true;
+
+        sorted.push_back(&it);
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](LiveInterval* a, LiveInterval* b) {
+        if(a->start != b->start)
+            return a->start < b->start;
+
+        return a->end != b->end ? a->end < b->end : a->order < b->order;
+    });
+
+    std::vector<LiveInterval*> active;
+    std::vector<bool> freeRegs(allocatableRegs.size(), true);
+    std::set<int> usedCalleeSaved;
+
+    for(LiveInterval* cur : sorted) {
+        // Expire the intervals that already ended
+        for(auto it = active.begin(); it != active.end();) {
+            if((*it)->end < cur->start) {
+                freeRegs[(*it)->reg] = true;
+                it = active.erase(it);
+            } else
+                it++;
+        }
+
+        // Values that survive a call can only go to the callee-saved registers,
+        // the others prefer the caller-saved ones since they don't need to be preserved
+        size_t limit = cur->crossesCall ? CALLEE_SAVED_REGS : allocatableRegs.size();
+        int reg = -1;
+        for(size_t r = limit; r-- > 0;) {
+            if(freeRegs[r]) {
+                reg = static_cast<int>(r);
+                break;
+            }
+        }
+
+        if(reg < 0) {
+            // Spill whoever ends last, as long as its register can be used by cur
+            auto victim = active.end();
+            for(auto it = active.begin(); it != active.end(); it++) {
+                if((*it)->reg < static_cast<int>(limit) && (victim == active.end() || (*it)->end > (*victim)->end))
+                    victim = it;
+            }
+
+            if(victim == active.end() || (*victim)->end <= cur->end)
+                continue; // cur stays in memory
+
+            reg = (*victim)->reg;
+            (*victim)->reg = -1;
+            active.erase(victim);
+        }
+
+        cur->reg = reg;
+        freeRegs[reg] = false;
+        active.push_back(cur);
+
+        if(reg < CALLEE_SAVED_REGS)
+            usedCalleeSaved.insert(reg);
+    }
+
+    registers.clear();
+    for(auto& entry : intervals)
+        if(entry.second.reg >= 0)
+            registers[entry.first] = entry.second.reg;
+
+    return std::vector<int>(usedCalleeSaved.begin(), usedCalleeSaved.end());
+}
+
+// %rsi is left out, handle_Mod divides by it
+static const std::array<std::string, 3> vectorBaseRegs = {"%rdi", "%r8", "%r9"};
+
+static Symbol* indexedVector(TAC* t) {
+    if(t->type == TACType::VECACCESS && memorySym.count(t->op1->symType))
+        return t->op2;
+
+    if(t->type == TACType::MOVEVEC && memorySym.count(t->op1->symType))
+        return t->res;
+
+    return nullptr;
+}
+
+VectorBases assignVectorBases(TAC* beginFun) {
+    VectorBases bases;
+    CFG* cfg = buildCFG(beginFun);
+    std::set<BasicBlock*> covered;
+
+    // Outer loops first, so the address is loaded as early as possible
+    for(auto it = cfg->loops.rbegin(); it != cfg->loops.rend(); it++) {
+        Loop* loop = *it;
+        BasicBlock* header = loop->header;
+
+        if(!header->reachable() || covered.count(header) || header->first->type != TACType::LABEL)
+            continue;
+
+        // The loads go right before the header label, so the loop can only be entered falling through into it
+        BasicBlock* before = cfg->blocks[header->id - 1];
+        bool enteredByFallthrough = before->last->type != TACType::JUMP && before->last->type != TACType::RET &&
+                                    !(before->last->type == TACType::IFZ && before->last->res == header->first->res);
+
+        for(BasicBlock* p : header->preds)
+            if(p->reachable() && !loop->contains(p) && p != before)
+                enteredByFallthrough = false;
+
+        if(!enteredByFallthrough)
+            continue;
+
+        bool hasCall = false;
+        std::vector<TAC*> accesses;
+
+        for(BasicBlock* b : loop->blocks) {
+            for(TAC* t = b->first; t; t = b->next(t)) {
+                if(isCall(t) || t->type == TACType::ARG)
+                    hasCall = true;
+
+                if(indexedVector(t))
+                    accesses.push_back(t);
+            }
+        }
+
+        if(hasCall || accesses.empty())
+            continue;
+
+        std::map<Symbol*, std::string> regOf;
+        for(TAC* t : accesses) {
+            Symbol* vec = indexedVector(t);
+
+            if(!regOf.count(vec)) {
+                if(regOf.size() == vectorBaseRegs.size())
+                    continue;
+
+                regOf[vec] = vectorBaseRegs[regOf.size()];
+                bases.loads[header->first].push_back({vec, regOf[vec]});
+            }
+
+            bases.baseReg[t] = regOf[vec];
+        }
+
+        covered.insert(loop->blocks.begin(), loop->blocks.end());
+    }
+
+    delete cfg;
+    return bases;
+}
@@ -0,0 +1,25 @@
+#ifndef ASM_REGALLOC_COMP
+#define ASM_REGALLOC_COMP
+
+#include "../tacs/tacs.h"
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Linear scan register allocation over the TACs of the function that starts at beginFun.
+// Temps, params and local variables get a register in registers (indexes into allocatableRegs), the ones
+// left out stay in memory. Returns the callee-saved registers that the function has to preserve
+std::vector<int> allocateRegisters(TAC* beginFun, std::unordered_map<Symbol*, int>& registers);
+
+// Base addresses of the vectors indexed by a computed value inside a loop, loaded once before the loop.
+// Only loops without calls, prints and reads get them, there the argument registers are free
+struct VectorBases {
+    std::map<TAC*, std::string> baseReg; // VECACCESS/MOVEVEC -> 64 bit register with the address of the vector
+    std::map<TAC*, std::vector<std::pair<Symbol*, std::string>>> loads; // LABEL of the loop header -> leaqs that go right before it
+};
+
+VectorBases assignVectorBases(TAC* beginFun);
+
+#endif /* ASM_REGALLOC_COMP */
@@ -1,6 +1,8 @@
 #include "asm_utils.h"
+#include "../context/context.h"
 
-std::map<DataType, int> dataSizeTable = {
+const std::map<DataType, int> dataSizeTable = {
+    {DataType::None, 0},
     {DataType::Int, 4},
     {DataType::Char, 1},
     {DataType::Bool, 1},
@@ -41,68 +43,102 @@ const std::array<std::string, 6> argumentLoc = {
     "%r9d", // 6th argument
 };
 
-std::map<Symbol*, bool> usedTemps = {};
+const std::array<std::string, 7> allocatableRegs = {
+    "%ebx",
+    "%r12d",
+    "%r13d",
+    "%r14d",
+    "%r15d",
+    "%r10d", // caller-saved from here on
+    "%r11d",
+};
+
+const std::array<std::string, 7> allocatableRegs64 = {
+    "%rbx",
+    "%r12",
+    "%r13",
+    "%r14",
+    "%r15",
+    "%r10",
+    "%r11",
+};
 
 // --- Utility Functions ---
-std::string symbolToAsm(Symbol* sym, int index) {
-    std::string res = "";
+
+// Temps left in memory get a slot in the data section (generateTemp), the function remembers the ones it used
+static void useTemp(Symbol* sym) {
+    FunctionContext* function = currentFunction();
+    (function ? function->usedTemps : context().usedTemps)[sym] = true;
+}
+
+// Params and locals are in the frame of the function being emitted (handle_BeginFun), the globals in .data
+static Operand memoryOperand(Symbol* sym) {
+    if(!sym->inStack)
+        return Operand::memory(sym->content, "%rip");
+
+    FunctionContext* function = currentFunction();
+    if(function) {
+        auto it = function->frameOffsets.find(sym);
+        if(it != function->frameOffsets.end())
+            return Operand::memory(it->second, "", "%rbp");
+    }
+
+    return Operand::memory(sym->content, "%rbp");
+}
+
+Operand symbolToAsm(Symbol* sym, int index) {
+    int reg = registerOf(sym);
+    if(reg >= 0)
+        return Operand::reg(allocatableRegs[reg]);
     
     switch(sym->symType) {
-        case SymbolType::Integer: {
-            res = "$" + std::to_string(std::stoi(sym->content)); // If I do it directly it breaks at 0
-            break;
-        }
-
-        case SymbolType::Char: {
-            res = "$" + std::to_string(static_cast<int>(sym->content[1]));
-            break;
-        }
+        case SymbolType::Integer:
+        case SymbolType::Char:
+        case SymbolType::Bool:
+            return Operand::immediate(sym->intValue);
 
         case SymbolType::Float:
-        case SymbolType::String: {
-            res = sym->label + "(%rip)";
-            break;
-        }
-
-        case SymbolType::Bool: {
-            res = "$" + std::to_string(((sym->content == "true") ? 1 : 0));
-            break;
-        }
+        case SymbolType::String:
+            return Operand::memory(sym->label, "%rip");
 
         case SymbolType::Temp:
-            usedTemps[sym] = true;
+            useTemp(sym);
         case SymbolType::Local:
-        case SymbolType::VarId: {
-            res = sym->content + ( sym->inStack ? "(%rbp)" : "(%rip)");
-            break;
-        }
+        case SymbolType::VarId:
+            return memoryOperand(sym);
 
         case SymbolType::VecId: {
             if(index >= 0)
-                res = std::to_string(dataSizeTable[sym->dataType] * index) + "+" + sym->content + "(%rip)";
-            else
-                res = "(%rdx,%rax)";
-            
-            break;
+                return Operand::memory(dataSizeTable.at(sym->dataType) * index, sym->content, "%rip");
+
+            return Operand::indexed("%rdx", "%rax");
         }
 
         default:
-            break;
+            return Operand();
     }
-
-    return res;
 };
 
-std::string getAsmDestination(Symbol* sym, int index) {
+Operand getAsmDestination(Symbol* sym, int index) {
+    int reg = registerOf(sym);
+    if(reg >= 0)
+        return Operand::reg(allocatableRegs[reg]);
+
     switch(sym->symType) {
         case SymbolType::Temp:
-            usedTemps[sym] = true;
+            useTemp(sym);
         case SymbolType::VarId:
         case SymbolType::Local:
-            return sym->content + ( sym->inStack ? "(%rbp)" : "(%rip)");
+            return memoryOperand(sym);
 
         case SymbolType::VecId:
-            return ( (index > 0) ? (std::to_string(dataSizeTable[sym->dataType] * index) + "+") : "") + sym->content + "(%rip)";
+            if(index < 0)
+                return Operand::indexed("%rdx", "%rax");
+
+            if(index > 0)
+                return Operand::memory(dataSizeTable.at(sym->dataType) * index, sym->content, "%rip");
+
+            return Operand::memory(sym->content, "%rip");
         
         // These cases are illegal as L-values
         case SymbolType::Integer:
@@ -117,17 +153,122 @@ std::string getAsmDestination(Symbol* sym, int index) {
 }
 
 
-TAC* goToTopTAC(TAC* code) {
-    if(code == nullptr)
-        return code;
+int registerOf(Symbol* sym) {
+    FunctionContext* function = currentFunction();
+    if(!sym || !function)
+        return -1;
+
+    auto it = function->registers.find(sym);
+    return it == function->registers.end() ? -1 : it->second;
+}
+
+bool inRegister(Symbol* sym) {
+    return registerOf(sym) >= 0;
+}
+
+// Params, local variables and the locals created by the optimizer, in the order they are laid out in the stack
+std::vector<Symbol*> getFrameSymbols(Symbol* func) {
+    const AST& ast = context().ast;
+    std::vector<Symbol*> frame(func->params.begin(), func->params.end());
+
+    // The second child of a DecFunc is its LocalVarDecList
+    if(func->value != NoNode)
+        for(ASTNodeId local : ast.children(ast.child(func->value, 1)))
+            frame.push_back(ast.symbol[local]);
+
+    frame.insert(frame.end(), func->extraLocals.begin(), func->extraLocals.end());
+
+    return frame;
+}
+
+void print_OriginalTAC(AsmBuffer& out, TAC* code) {
+    out << "\n# TAC " << getTACTypeString(code->type) << "\n";
+}
+
+static bool isComparison(TACType type) {
+    return type == TACType::LESS || type == TACType::GREATER || type == TACType::LESSEQUAL ||
+           type == TACType::GREATEREQUAL || type == TACType::EQUAL || type == TACType::NOTEQUAL;
+}
+
+std::unordered_set<TAC*> findFusedBranches(TAC* beginFun) {
+    std::map<Symbol*, int> useCount;
+    std::unordered_set<TAC*> fused;
+
+    for(TAC* t = beginFun; t && t->type != TACType::ENDFUN; t = t->next)
+        for(Symbol* use : tacUses(t))
+            useCount[use]++;
+
+    for(TAC* t = beginFun; t && t->type != TACType::ENDFUN; t = t->next) {
+        if(!isComparison(t->type) || t->res->symType != SymbolType::Temp)
+            continue;
+
+        TAC* next = t->next;
+        if(next && next->type == TACType::IFZ && next->op1 == t->res && useCount[t->res] == 1)
+            fused.insert(t);
+    }
+
+    return fused;
+}
+
+std::unordered_set<Symbol*> findLoopHeaders(TAC* beginFun) {
+    std::unordered_set<Symbol*> seen;
+    std::unordered_set<Symbol*> headers;
 
-    TAC* cur;
+    for(TAC* t = beginFun; t && t->type != TACType::ENDFUN; t = t->next) {
+        if(t->type == TACType::LABEL)
+            seen.insert(t->res);
 
-    for(cur = code; cur->prev != nullptr; cur = cur->prev);
+        if((t->type == TACType::JUMP || t->type == TACType::IFZ) && seen.count(t->res))
+            headers.insert(t->res);
+    }
 
-    return cur;
+    return headers;
 }
 
-void print_OriginalTAC(std::ostringstream& oss, TAC* code) {
-    oss << "\n# TAC " << code->type << "\n";
-}
\ No newline at end of file
+StagedArgs findStagedArgs(TAC* beginFun) {
+    // Calls whose ARGs started and whose CALL didn't come yet, the innermost last. The ARGs of a call come in
+    // parameter order, so one that doesn't follow the last ARG of the innermost call to its function starts a new call
+    struct OpenCall {
+        Symbol* function;
+        int lastIndex;
+        std::vector<TAC*> args;
+    };
+
+    std::vector<OpenCall> open;
+    StagedArgs staged;
+
+    for(TAC* t = beginFun; t && t->type != TACType::ENDFUN; t = t->next) {
+        if(t->type == TACType::ARG) {
+            int index = t->res->getParamIndex(t->op2);
+
+            if(open.empty() || open.back().function != t->res || open.back().lastIndex >= index)
+                open.push_back({t->res, -1, {}});
+
+            open.back().lastIndex = index;
+            open.back().args.push_back(t);
+            continue;
+        }
+
+        if(t->type != TACType::CALL || open.empty() || open.back().function != t->op1)
+            continue;
+
+        // Only the ARGs right before the CALL, with nothing else in between, are moved to their registers directly
+        std::vector<TAC*>& args = open.back().args;
+        size_t direct = args.size();
+        for(TAC* after = t; direct > 0 && args[direct - 1]->next == after; direct--)
+            after = args[direct - 1];
+
+        for(size_t i = 0; i < direct; i++) {
+            int index = t->op1->getParamIndex(args[i]->op2);
+            if(index < 0)
+                continue;
+
+            staged.args.insert(args[i]);
+            staged.calls[t].push_back(index);
+        }
+
+        open.pop_back();
+    }
+
+    return staged;
+}
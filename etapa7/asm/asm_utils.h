@@ -3,15 +3,18 @@
 
 #include "../symbols/symbols.h" // Include your symbol header
 #include "../tacs/tacs.h"         // Include your TAC header
+#include "asm_writer.h"
 
+#include <unordered_map>
 #include <unordered_set>
 #include <array>
 #include <string>
 #include <map>
 #include <sstream>
+#include <vector>
 
 // A map for data type sizes (use 'extern' to define it once in the .cpp)
-extern std::map<DataType, int> dataSizeTable;
+extern const std::map<DataType, int> dataSizeTable;
 
 // A set that defines the TACs that will leave the result into the register
 extern const std::unordered_set<TACType> reusableResEax;
@@ -22,12 +25,35 @@ extern const std::unordered_set<SymbolType> memorySym;
 // The index is the same as the argument in the function, while the returning string holds the register for passing the arg
 extern const std::array<std::string, 6> argumentLoc;
 
-extern std::map<Symbol*, bool> usedTemps;
+// Registers given out by the register allocator (32 and 64 bit names). The first CALLEE_SAVED_REGS are
+// callee-saved, so only they can hold values that are alive across a call
+#define CALLEE_SAVED_REGS 5
+extern const std::array<std::string, 7> allocatableRegs;
+extern const std::array<std::string, 7> allocatableRegs64;
 
 // --- Utility Functions ---
-std::string symbolToAsm(Symbol* sym, int index = 0);
-std::string getAsmDestination(Symbol* sym, int index = 0);
-void print_OriginalTAC(std::ostringstream& oss, TAC* code);
-TAC* goToTopTAC(TAC* code);
+// Where sym is read from and written to, an index < 0 is the element at (%rdx,%rax)
+Operand symbolToAsm(Symbol* sym, int index = 0);
+Operand getAsmDestination(Symbol* sym, int index = 0);
+void print_OriginalTAC(AsmBuffer& out, TAC* code);
+int registerOf(Symbol* sym);    // Given by the allocator in the function being emitted, -1 when sym is in memory
+bool inRegister(Symbol* sym);
+std::vector<Symbol*> getFrameSymbols(Symbol* func);
+
+// Comparisons of the function whose result is only read by the IFZ right after them, they are emitted as cmpl + jcc
+std::unordered_set<TAC*> findFusedBranches(TAC* beginFun);
+
+// Labels of the function that are the target of a jump coming from below them, the loop headers
+std::unordered_set<Symbol*> findLoopHeaders(TAC* beginFun);
+
+// ARGs of the function that can't go straight to their register, because code that may use the argument registers
+// (another call, the scratch registers of the handlers) runs between them and their CALL. They wait on the stack and
+// the CALL loads them right before the call
+struct StagedArgs {
+    std::unordered_set<TAC*> args;
+    std::unordered_map<TAC*, std::vector<int>> calls;  // CALL -> parameter index of each of its staged ARGs, in order
+};
+
+StagedArgs findStagedArgs(TAC* beginFun);
 
 #endif /* ASM_UTILS_COMP */
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "asm_writer.h"
+
+#include <algorithm>
+
+Operand Operand::reg(std::string_view name) {
+    Operand operand;
+    operand.kind = Kind::Register;
+    operand.name = name;
+    return operand;
+}
+
+Operand Operand::immediate(long value) {
+    Operand operand;
+    operand.kind = Kind::Immediate;
+    operand.value = value;
+    return operand;
+}
+
+Operand Operand::memory(std::string_view symbol, std::string_view base) {
+    Operand operand;
+    operand.kind = Kind::Memory;
+    operand.name = symbol;
+    operand.base = base;
+    return operand;
+}
+
+Operand Operand::memory(long displacement, std::string_view symbol, std::string_view base) {
+    Operand operand = memory(symbol, base);
+    operand.value = displacement;
+    operand.displaced = true;
+    return operand;
+}
+
+Operand Operand::indexed(std::string_view base, std::string_view index, int scale) {
+    Operand operand = memory("", base);
+    operand.index = index;
+    operand.scale = scale;
+    return operand;
+}
+
+void AsmBuffer::grow(size_t extra) {
+    // Doubles, starting with a few pages, so a function is copied O(1) times on average
+    size_t newCapacity = std::max({capacity * 2, length + extra, size_t(16 * 1024)});
+    std::unique_ptr<char[]> bigger(new char[newCapacity]);
+
+    if(length > 0)
+        std::memcpy(bigger.get(), text.get(), length);
+
+    text = std::move(bigger);
+    capacity = newCapacity;
+}
+
+void AsmBuffer::release() {
+    text.reset();
+    length = capacity = 0;
+}
+
+AsmBuffer& AsmBuffer::operator<<(unsigned long value) {
+    // Digits from the end of a buffer on the stack, 20 is enough for 2^64 - 1
+    char digits[20];
+    char* end = digits + sizeof(digits);
+    char* p = end;
+
+    do {
+        *--p = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while(value != 0);
+
+    append(p, end - p);
+    return *this;
+}
+
+AsmBuffer& AsmBuffer::operator<<(long value) {
+    if(value < 0) {
+        *this << '-';
+        // Negated as unsigned, so LONG_MIN works too
+        return *this << (0ul - static_cast<unsigned long>(value));
+    }
+
+    return *this << static_cast<unsigned long>(value);
+}
+
+AsmBuffer& AsmBuffer::operator<<(const Operand& operand) {
+    switch(operand.kind) {
+        case Operand::Kind::Register:
+            return *this << operand.name;
+
+        case Operand::Kind::Immediate:
+            return *this << '$' << operand.value;
+
+        case Operand::Kind::Memory:
+            break;
+    }
+
+    if(operand.displaced) {
+        *this << operand.value;
+        if(!operand.name.empty())
+            *this << '+';
+    }
+
+    *this << operand.name << '(' << operand.base;
+
+    if(!operand.index.empty()) {
+        *this << ',' << operand.index;
+        if(operand.scale != 0)
+            *this << ',' << operand.scale;
+    }
+
+    return *this << ')';
+}
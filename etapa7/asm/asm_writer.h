@@ -0,0 +1,86 @@
+#ifndef ASM_WRITER_COMP
+#define ASM_WRITER_COMP
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Operand of an instruction kept as its pieces and formatted straight into an AsmBuffer, so the handlers don't
+// build a std::string for each one. The names point to strings that outlive the instruction: the content of the
+// symbols and the register tables of asm_utils
+struct Operand {
+    enum class Kind : unsigned char { Register, Immediate, Memory };
+
+    Kind kind = Kind::Register;
+    std::string_view name;      // The register, or the symbol before the parentheses of a Memory (may be empty)
+    long value = 0;             // Immediate, or the displacement of a Memory
+    bool displaced = false;     // Memory: value is written, even when it is 0
+    std::string_view base;      // Memory: base register
+    std::string_view index;     // Memory: index register, empty when there is none
+    int scale = 0;              // Memory: written only when it isn't 0
+
+    // %reg, $value, [displacement+]symbol(base), displacement(base) and (base,index[,scale])
+    static Operand reg(std::string_view name);
+    static Operand immediate(long value);
+    static Operand memory(std::string_view symbol, std::string_view base);
+    static Operand memory(long displacement, std::string_view symbol, std::string_view base);
+    static Operand indexed(std::string_view base, std::string_view index, int scale = 0);
+};
+
+// Append-only text of the assembly of a function. Numbers and operands are formatted in place, the only allocation
+// is the buffer growing, which keeps its size across clear()
+class AsmBuffer {
+    public:
+        AsmBuffer() = default;
+
+        AsmBuffer(const AsmBuffer&) = delete;
+        AsmBuffer& operator=(const AsmBuffer&) = delete;
+
+        AsmBuffer& operator<<(std::string_view text) {
+            append(text.data(), text.size());
+            return *this;
+        }
+
+        AsmBuffer& operator<<(const char* text) { return *this << std::string_view(text); }
+        AsmBuffer& operator<<(const std::string& text) { return *this << std::string_view(text); }
+
+        AsmBuffer& operator<<(char c) {
+            if(length == capacity)
+                grow(1);
+
+            text[length++] = c;
+            return *this;
+        }
+
+        AsmBuffer& operator<<(int value) { return *this << static_cast<long>(value); }
+        AsmBuffer& operator<<(unsigned value) { return *this << static_cast<unsigned long>(value); }
+        AsmBuffer& operator<<(long value);
+        AsmBuffer& operator<<(unsigned long value);
+        AsmBuffer& operator<<(const Operand& operand);
+
+        const char* data() const { return text.get(); }
+        size_t size() const { return length; }
+        std::string_view view() const { return std::string_view(text.get(), length); }
+
+        void clear() { length = 0; }
+        void release();     // clear() and give the memory back
+
+    private:
+        void append(const char* data, size_t size) {
+            if(capacity - length < size)
+                grow(size);
+
+            std::memcpy(text.get() + length, data, size);
+            length += size;
+        }
+
+        void grow(size_t extra);
+
+        std::unique_ptr<char[]> text;
+        size_t length = 0;
+        size_t capacity = 0;
+};
+
+#endif /* ASM_WRITER_COMP */
@@ -2,7 +2,72 @@
 #include <iostream>
 #include <map>
 
-void ASTNode::print(const std::string& prefix, bool isLast) const {
+ASTNodeId AST::newNode(ASTNodeType nodeType, Symbol* nodeSymbol, DataType datatype) {
+    ASTNodeId node = type.size();
+
+    type.push_back(nodeType);
+    symbol.push_back(nodeSymbol);
+    parent.push_back(NoNode);
+    inferedType.push_back(DataType::None);
+    firstChild.push_back(childSlots.size());
+    childCount.push_back(0);
+
+    if(nodeSymbol != nullptr) {
+        if(datatype != DataType::None) {
+            nodeSymbol->dataType = datatype;
+            inferedType[node] = datatype;
+        }
+
+        if(nodeType == ASTNodeType::Param) {
+            nodeSymbol->inStack = true;
+        }
+    }
+
+    return node;
+}
+
+ASTNodeId AST::add(ASTNodeType nodeType, std::initializer_list<ASTNodeId> children, Symbol* nodeSymbol, DataType datatype) {
+    // The children were created before the node, so its slots go at the end and stay together
+    for(ASTNodeId child : children) {
+        childSlots.push_back(child);
+    }
+
+    ASTNodeId node = newNode(nodeType, nodeSymbol, datatype);
+    firstChild[node] = childSlots.size() - children.size();
+    childCount[node] = children.size();
+
+    for(ASTNodeId child : children)
+        parent[child] = node;
+
+    return node;
+}
+
+ASTNodeId AST::addList(ASTNodeType nodeType, const std::vector<ASTNodeId>& items) {
+    ASTNodeId node = newNode(nodeType, nullptr, DataType::None);
+    childCount[node] = items.size();
+
+    for(auto it = items.rbegin(); it != items.rend(); it++) {
+        childSlots.push_back(*it);
+        parent[*it] = node;
+
+        if(nodeType == ASTNodeType::LocalVarDecList && symbol[*it])
+            symbol[*it]->inStack = true;
+    }
+
+    return node;
+}
+
+void AST::clear() {
+    type.clear();
+    symbol.clear();
+    parent.clear();
+    inferedType.clear();
+    firstChild.clear();
+    childCount.clear();
+    childSlots.clear();
+}
+
+void AST::print(ASTNodeId node, const std::string& prefix, bool isLast) const {
     std::cout << prefix;
 
     if (!prefix.empty()) {
@@ -13,210 +78,173 @@ void ASTNode::print(const std::string& prefix, bool isLast) const {
         }
     }
 
-    std::cout << type;
+    std::cout << type[node];
 
-    if(inferedType != DataType::None) {
-        std::cout << " : " << inferedType << " ";
+    if(inferedType[node] != DataType::None) {
+        std::cout << " : " << inferedType[node] << " ";
     }
 
-    if(symbol)
-        if(symbol->params.size() > 0) {
-            std::cout << " [" << symbol->content  << "(";
-            for(size_t i = 0; i < symbol->params.size(); i++) {
+    Symbol* sym = symbol[node];
+    if(sym)
+        if(sym->params.size() > 0) {
+            std::cout << " [" << sym->content  << "(";
+            for(size_t i = 0; i < sym->params.size(); i++) {
                 if(i > 0)
                     std::cout << ", ";
-                std::cout << symbol->params[i]->dataType;
+                std::cout << sym->params[i]->dataType;
             }
             std::cout << ")]" << "\n";
         } else
-            std::cout << "[" << symbol->content  << "]" << "\n";
+            std::cout << "[" << sym->content  << "]" << "\n";
     else
         std::cout << "\n";
 
-    for (size_t i = 0; i < children.size(); i++) {
-        if(children[i] == nullptr)
-            continue;
-            
-        const bool last = (i == children.size() - 1);
-        children[i]->print(prefix + (isLast ? "  " : "│ "), last);
+    ASTChildren kids = children(node);
+    for (size_t i = 0; i < kids.size(); i++) {
+        const bool last = (i == kids.size() - 1);
+        print(kids[i], prefix + (isLast ? "  " : "│ "), last);
+    }
+}
+
+static std::string typeName(DataType type) {
+    switch(type) {
+        case DataType::Int:  return "int";
+        case DataType::Char: return "char";
+        case DataType::Bool: return "bool";
+        case DataType::Real: return "float";
+        default:             return "";
     }
 }
 
-std::string ASTNode::generateSourceCode(int indent) const {
+std::string AST::generateSourceCode(ASTNodeId node, int indent) const {
     auto ind = std::string(indent * 2, ' ');
+    ASTChildren kids = children(node);
+
+    // Elements of a list node, each one as code and joined by sep
+    auto join = [&](const std::string& sep, int childIndent) {
+        std::string code;
+        for (size_t i = 0; i < kids.size(); i++) {
+            if (i > 0) code += sep;
+            code += generateSourceCode(kids[i], childIndent);
+        }
+        return code;
+    };
+
+    auto binary = [&](const std::string& op) {
+        return generateSourceCode(kids[0]) + " " + op + " " + generateSourceCode(kids[1]);
+    };
 
-    switch (type) {
+    switch (type[node]) {
         // === LITERALS & IDENTIFIERS ===
         case ASTNodeType::Identifier:
         case ASTNodeType::Lit:
-            return symbol ? symbol->content : "";
+            return symbol[node] ? symbol[node]->content : "";
 
         // === DECLARATIONS ===
         case ASTNodeType::DecVar:
-            return ind + children[0]->generateSourceCode() + " " + symbol->content +
-                   " = " + children[1]->generateSourceCode() + ";\n";
+            return ind + typeName(symbol[node]->dataType) + " " + symbol[node]->content +
+                   " = " + generateSourceCode(kids[0]) + ";\n";
 
         case ASTNodeType::DecVarArray: {
             std::string init;
-            if (children.size() > 1 && children[2]) init = " = " + children[2]->generateSourceCode();
-            return ind + children[0]->generateSourceCode() + " " + symbol->content +
-                   "[" + children[1]->generateSourceCode() + "]" + init + ";\n";
-        }
-
-        case ASTNodeType::VetInit: {
-            std::string code;
-            for (auto* c : children) if (c) {
-                if (!code.empty()) code += " ";
-                code += c->generateSourceCode();
-            }
-            return code;
+            if (childCount[kids[1]] > 0) init = " = " + generateSourceCode(kids[1]);
+            return ind + typeName(symbol[node]->dataType) + " " + symbol[node]->content +
+                   "[" + generateSourceCode(kids[0]) + "]" + init + ";\n";
         }
 
-        case ASTNodeType::DecFunc: {
-            ASTNode* returnType = children[0];
-            ASTNode* param  = nullptr;
-            ASTNode* localVarDecs = nullptr;
-            ASTNode* block = nullptr;
-
-            for (size_t i = 1; i < children.size(); i++) {
-                switch (children[i]->type) {
-                    case ASTNodeType::ParamList:        
-                        param = children[i]; 
-                        break;
-
-                    case ASTNodeType::LocalVarDecList:  
-                        localVarDecs = children[i]; 
-                        break;
+        case ASTNodeType::VetInit:
+            return join(" ", 0);
 
-                    case ASTNodeType::Block:            
-                        block = children[i]; 
-                        break;
-
-                    default: break;
-                }
-            }
-
-            return ind + returnType->generateSourceCode() + " " + symbol->content +
-                   "(" + (param ? param->generateSourceCode() : "") + ")\n" + 
-                   (localVarDecs ? localVarDecs->generateSourceCode(indent + 1) : "") +
-                   (block ? block->generateSourceCode(indent) : "");
-        }
+        case ASTNodeType::DecFunc:
+            return ind + typeName(symbol[node]->dataType) + " " + symbol[node]->content +
+                   "(" + generateSourceCode(kids[0]) + ")\n" +
+                   generateSourceCode(kids[1], indent + 1) +
+                   generateSourceCode(kids[2], indent);
 
         case ASTNodeType::Param:
-            return children[0]->generateSourceCode() + " " + symbol->content;
+            return typeName(symbol[node]->dataType) + " " + symbol[node]->content;
 
-        case ASTNodeType::ParamList: {
-            std::string left = children[0] ? children[0]->generateSourceCode() : "";
-            std::string right = children[1] ? children[1]->generateSourceCode() : "";
-            if (!left.empty() && !right.empty()) return left + ", " + right;
-            return left + right;
-        }
+        case ASTNodeType::ParamList:
+        case ASTNodeType::ArgList:
+            return join(", ", 0);
 
-        case ASTNodeType::LocalVarDecList: {
-            std::string code;
-            for (auto* c : children) if (c) code += c->generateSourceCode(indent);
-            return code;
-        }
+        case ASTNodeType::LocalVarDecList:
+        case ASTNodeType::CmdList:
+        case ASTNodeType::DecList:
+            return join("", indent);
 
         // === BLOCK ===
-        case ASTNodeType::Block: {
-            std::string code = ind + "{\n";
-            for (auto* c : children) if (c) code += c->generateSourceCode(indent + 1);
-            code += ind + "}\n";
-            return code;
-        }
-        
+        case ASTNodeType::Block:
+            return ind + "{\n" + generateSourceCode(kids[0], indent + 1) + ind + "}\n";
+
         case ASTNodeType::EmptyBlock:
             return ind + "{ }\n";
 
         // === COMMANDS  ===
-        case ASTNodeType::CmdList: {
-            std::string code;
-            for (auto* c : children) if (c) code += c->generateSourceCode(indent);
-            return code;
-        }
-
         case ASTNodeType::CmdAssign:
-            return ind + symbol->content + " = " + children[0]->generateSourceCode() + ";\n";
+            return ind + symbol[node]->content + " = " + generateSourceCode(kids[0]) + ";\n";
 
         case ASTNodeType::CmdArrayElementAssign:
-            return ind + symbol->content + "[" + children[0]->generateSourceCode() + "] = " +
-                   children[1]->generateSourceCode() + ";\n";
+            return ind + symbol[node]->content + "[" + generateSourceCode(kids[0]) + "] = " +
+                   generateSourceCode(kids[1]) + ";\n";
 
         case ASTNodeType::CmdRead:
-            return ind + "read " + symbol->content + ";\n";
+            return ind + "read " + symbol[node]->content + ";\n";
 
         case ASTNodeType::CmdPrint:
-            return ind + "print " + children[0]->generateSourceCode() + ";\n";
+            return ind + "print " + generateSourceCode(kids[0]) + ";\n";
 
         case ASTNodeType::CmdReturn:
-            return ind + "return " + children[0]->generateSourceCode() + ";\n";
+            return ind + "return " + generateSourceCode(kids[0]) + ";\n";
 
         case ASTNodeType::CmdIf:
-            return ind + "if (" + children[0]->generateSourceCode() + ")\n" +
-                   children[1]->generateSourceCode(indent);
+            return ind + "if (" + generateSourceCode(kids[0]) + ")\n" +
+                   generateSourceCode(kids[1], indent);
 
         case ASTNodeType::CmdIfElse:
-            return ind + "if (" + children[0]->generateSourceCode() + ")\n" +
-                   children[1]->generateSourceCode(indent) +
-                   ind + "else \n" + children[2]->generateSourceCode(indent + 1);
+            return ind + "if (" + generateSourceCode(kids[0]) + ")\n" +
+                   generateSourceCode(kids[1], indent) +
+                   ind + "else \n" + generateSourceCode(kids[2], indent + 1);
 
         case ASTNodeType::CmdWhile:
-            return ind + "while (" + children[0]->generateSourceCode() + ")\n" +
-                   children[1]->generateSourceCode(indent);
+            return ind + "while (" + generateSourceCode(kids[0]) + ")\n" +
+                   generateSourceCode(kids[1], indent);
 
         case ASTNodeType::CmdEmpty:
             return "";
             // return ind + " ;\n";
 
         // === PRINT LIST ===
-        case ASTNodeType::PrintList: {
-            std::string code;
-            if (symbol) code += symbol->content;
-            for (auto* c : children) if (c) {
-                if (!code.empty()) code += " ";
-                code += c->generateSourceCode();
-            }
-            return code;
-        }
+        case ASTNodeType::PrintList:
+            return join(" ", 0);
 
         // === FUNCTION CALL ===
         case ASTNodeType::FuncCall:
-            return symbol->content + "(" +
-                   (children.size() > 0 && children[0] ? children[0]->generateSourceCode() : "") + ")";
-
-        case ASTNodeType::ArgList: {
-            std::string left = children[0] ? children[0]->generateSourceCode() : "";
-            std::string right = children[1] ? children[1]->generateSourceCode() : "";
-            if (!left.empty() && !right.empty()) return left + ", " + right;
-            return left + right;
-        }
+            return symbol[node]->content + "(" + generateSourceCode(kids[0]) + ")";
 
         // === EXPRESSIONS ===
-        case ASTNodeType::OpAdd: return children[0]->generateSourceCode() + " + " + children[1]->generateSourceCode();
-        case ASTNodeType::OpSub: return children[0]->generateSourceCode() + " - " + children[1]->generateSourceCode();
-        case ASTNodeType::OpMul: return children[0]->generateSourceCode() + " * " + children[1]->generateSourceCode();
-        case ASTNodeType::OpDiv: return children[0]->generateSourceCode() + " / " + children[1]->generateSourceCode();
-        case ASTNodeType::OpMod: return children[0]->generateSourceCode() + " % " + children[1]->generateSourceCode();
-        case ASTNodeType::OpLess: return children[0]->generateSourceCode() + " < " + children[1]->generateSourceCode();
-        case ASTNodeType::OpGreater: return children[0]->generateSourceCode() + " > " + children[1]->generateSourceCode();
-        case ASTNodeType::OpEqual: return children[0]->generateSourceCode() + " == " + children[1]->generateSourceCode();
-        case ASTNodeType::OpNotEqual: return children[0]->generateSourceCode() + " != " + children[1]->generateSourceCode();
-        case ASTNodeType::OpLessEqual: return children[0]->generateSourceCode() + " <= " + children[1]->generateSourceCode();
-        case ASTNodeType::OpGreaterEqual: return children[0]->generateSourceCode() + " >= " + children[1]->generateSourceCode();
-        case ASTNodeType::OpAnd: return children[0]->generateSourceCode() + " & " + children[1]->generateSourceCode();
-        case ASTNodeType::OpOr: return children[0]->generateSourceCode() + " | " + children[1]->generateSourceCode();
-        case ASTNodeType::OpAssign: return children[0]->generateSourceCode() + " = " + children[1]->generateSourceCode();
-        case ASTNodeType::OpNot: return "~" + children[0]->generateSourceCode();
+        case ASTNodeType::OpAdd: return binary("+");
+        case ASTNodeType::OpSub: return binary("-");
+        case ASTNodeType::OpMul: return binary("*");
+        case ASTNodeType::OpDiv: return binary("/");
+        case ASTNodeType::OpMod: return binary("%");
+        case ASTNodeType::OpLess: return binary("<");
+        case ASTNodeType::OpGreater: return binary(">");
+        case ASTNodeType::OpEqual: return binary("==");
+        case ASTNodeType::OpNotEqual: return binary("!=");
+        case ASTNodeType::OpLessEqual: return binary("<=");
+        case ASTNodeType::OpGreaterEqual: return binary(">=");
+        case ASTNodeType::OpAnd: return binary("&");
+        case ASTNodeType::OpOr: return binary("|");
+        case ASTNodeType::OpAssign: return binary("=");
+        case ASTNodeType::OpNot: return "~" + generateSourceCode(kids[0]);
+
+        case ASTNodeType::ArrayElement:
+            return symbol[node]->content + "[" + generateSourceCode(kids[0]) + "]";
 
         // === TOP LEVEL ===
-        case ASTNodeType::DecList: {
-            std::string code;
-            for (auto* c : children) if (c) code += c->generateSourceCode(indent);
-            return code;
-        }
         case ASTNodeType::Program:
-            return children[0]->generateSourceCode(indent);
+            return generateSourceCode(kids[0], indent);
 
         default:
             return "";
@@ -2,6 +2,8 @@
 #define COMP_AST
 
 #include "../symbols/symbols.h"
+#include <cstdint>
+#include <initializer_list>
 #include <vector>
 #include <string>
 
@@ -56,42 +58,51 @@ enum class ASTNodeType {
     CmdWhile
 };
 
-class ASTNode {
+// Children of a node, a contiguous run of the child slots of the AST
+struct ASTChildren {
+    const ASTNodeId* first;
+    const ASTNodeId* last;
+
+    const ASTNodeId* begin() const { return first; }
+    const ASTNodeId* end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    ASTNodeId operator[](size_t i) const { return first[i]; }
+};
+
+// The whole tree in struct of arrays form, node i is type[i], symbol[i], ... Nodes only hold 32 bit ids,
+// and lists (DecList, CmdList, VetInit, ...) are a single node with one child per element instead of a right nested chain
+class AST {
     public:
-        ASTNodeType type;
-        std::vector<ASTNode*> children;
-        Symbol* symbol; // only for leaf nodes
-        ASTNode* parent;
-        DataType inferedType;
-
-        ASTNode(ASTNodeType type, std::vector<ASTNode*> children = {}, Symbol* symbol = nullptr, DataType datatype = DataType::None)
-            : type(type), symbol(symbol), parent(nullptr), inferedType(DataType::None) {                
-                this->children.reserve(children.size());
-                for (auto* child : children) {
-                    if (child != nullptr) {
-                        this->children.push_back(child);
-                        child->parent = this;
-                    }
-                }
-                
-                if(type == ASTNodeType::LocalVarDecList) {
-                    if(children[0] && children[0]->symbol) children[0]->symbol->inStack = true;
-                }
-
-                if(symbol != nullptr) {
-                    if(datatype != DataType::None) {
-                        symbol->dataType = datatype;
-                        inferedType = datatype;
-                    }
-
-                    if(type == ASTNodeType::Param) {
-                        symbol->inStack = true;
-                    }
-                }
-            }
-
-        void print(const std::string& prefix = "", bool isLast = true) const;
-        std::string generateSourceCode(int indent = 0) const;
+        std::vector<ASTNodeType> type;
+        std::vector<Symbol*> symbol;        // only for leaf nodes and declarations
+        std::vector<ASTNodeId> parent;
+        std::vector<DataType> inferedType;
+        std::vector<uint32_t> firstChild;   // Children of i: childSlots[firstChild[i], firstChild[i] + childCount[i])
+        std::vector<uint32_t> childCount;
+        std::vector<ASTNodeId> childSlots;
+
+        ASTNodeId add(ASTNodeType type, std::initializer_list<ASTNodeId> children = {}, Symbol* symbol = nullptr,
+                      DataType datatype = DataType::None);
+
+        // items in reverse order, as the right recursive rules of the parser collect them
+        ASTNodeId addList(ASTNodeType type, const std::vector<ASTNodeId>& items);
+
+        ASTChildren children(ASTNodeId node) const {
+            const ASTNodeId* first = childSlots.data() + firstChild[node];
+            return {first, first + childCount[node]};
+        }
+
+        ASTNodeId child(ASTNodeId node, size_t i) const { return i < childCount[node] ? childSlots[firstChild[node] + i] : NoNode; }
+
+        size_t size() const { return type.size(); }
+        void clear();
+
+        void print(ASTNodeId node, const std::string& prefix = "", bool isLast = true) const;
+        std::string generateSourceCode(ASTNodeId node, int indent = 0) const;
+
+    private:
+        ASTNodeId newNode(ASTNodeType type, Symbol* symbol, DataType datatype);
 };
 
 std::ostream& operator<<(std::ostream& out, const ASTNodeType& value);
@@ -0,0 +1,154 @@
+// Microbenchmark of the backend: how many MB/s of assembly generateAsm writes for a large synthetic program.
+// Call: ./asm_bench [functions] [runs] [file.s]. The program is parsed and optimized once, then emitted runs
+// times into a sink that only counts the bytes, and the best run is reported. The time covers everything
+// generateAsm does per function (register allocation, branch fusion, ...) and the formatting of the text.
+// With file.s the assembly is emitted once more into it, for checking it
+
+#include "../asm/asm.h"
+#include "../tacs/tacs.h"
+#include "../semantic_check/semantic_check.h"
+#include "../lexer/lexer.h"
+#include "../context/context.h"
+#include "../output/output_file.h"
+#include "../parser.tab.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+// Discards what is written to it, counting the bytes
+class CountingSink : public std::streambuf {
+    public:
+        size_t bytes = 0;
+
+    protected:
+        int_type overflow(int_type ch) override {
+            if(!traits_type::eq_int_type(ch, traits_type::eof()))
+                bytes++;
+
+            return traits_type::not_eof(ch);
+        }
+
+        std::streamsize xsputn(const char*, std::streamsize n) override {
+            bytes += n;
+            return n;
+        }
+};
+
+// functions functions, each one calling the one before it, with loops, branches, vectors, division,
+// short-circuit logic and prints, so every handler of the backend gets used. Params and locals have the number
+// of their function in the name, a name can only be declared once in the whole program
+static std::string syntheticProgram(size_t functions) {
+    std::ostringstream src;
+
+    src << "int v[16];\nint g = 0;\nbool t = true;\nbool f = false;\nbool r = false;\n\n";
+
+    for(size_t i = 0; i < functions; i++) {
+        std::string n = std::to_string(i);
+        std::string a = "a" + n, b = "b" + n, s = "s" + n, k = "k" + n;
+
+        src << "int f" << n << "(int " << a << ", int " << b << ")\n"
+               "int " << s << " = " << i % 100 << ";\n"
+               "int " << k << " = 0;\n"
+               "{\n"
+               "    " << k << " = 0;\n"
+               "    while(" << k << " < " << a << ") {\n"
+               "        " << s << " = " << s << " + " << a << " * " << b << " - " << k << " / 3 + (" << s << " % 7) * 2;\n"
+               "        if(" << s << " > 1000) {\n"
+               "            " << s << " = " << s << " / " << b << ";\n"
+               "        } else {\n"
+               "            " << s << " = " << s << " + 1;\n"
+               "        }\n"
+               "        v[" << k << " % 16] = " << s << " + v[(" << k << " + 1) % 16];\n"
+               "        " << k << " = " << k << " + 1;\n"
+               "    }\n"
+               "    r = (t & (" << s << " > " << b << ")) | (f & (" << a << " == " << b << "));\n"
+               "    print \"f" << n << " \" " << s << " \" \" r \"\\n\";\n";
+
+        if(i > 0)
+            src << "    g = g + f" << i - 1 << "(" << s << " % 10, " << b << " + 1);\n";
+
+        src << "    return " << s << " + v[3];\n"
+               "}\n\n";
+    }
+
+    src << "int main() {\n"
+           "    g = f" << functions - 1 << "(5, 3);\n"
+           "    print g \"\\n\";\n"
+           "}\n";
+
+    return src.str();
+}
+
+int main(int argc, char** argv) {
+    size_t functions = argc > 1 ? std::stoul(argv[1]) : 2000;
+    int runs = argc > 2 ? std::stoi(argv[2]) : 5;
+    std::string output = argc > 3 ? argv[3] : "";
+
+    if(functions == 0 || runs <= 0) {
+        fprintf(stderr, "Call: ./asm_bench [functions > 0] [runs > 0] [file.s]\n");
+        return 1;
+    }
+
+    std::string source = syntheticProgram(functions);
+    size_t size = source.size();
+    source.append(LexerPadding, '\0');
+
+    // The TACs the front end prints go nowhere
+    std::ostream discard(nullptr);
+
+    CompilationContext ctx;
+    ContextScope scope(ctx);
+    ctx.out = &discard;
+
+    useHandLexer(ctx, source.data(), size);
+    while(ctx.running)
+        yyparse(ctx);
+
+    if(ctx.syntaxErrors > 0 || ASTSemErrorCheck(ctx.root)) {
+        fprintf(stderr, "The synthetic program doesn't compile\n");
+        return 1;
+    }
+
+    TACList code = generateCode(ctx.root);
+
+    double best = 0;
+    size_t bytes = 0;
+
+    for(int run = 0; run < runs; run++) {
+        CountingSink sink;
+        std::ostream out(&sink);
+
+        auto start = std::chrono::steady_clock::now();
+        generateAsm(code, out);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        bytes = sink.bytes;
+        best = run == 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+
+    if(!output.empty()) {
+        OutputFile file;
+        bool written = file.open(output);
+
+        if(written) {
+            std::ostream out(&file);
+            generateAsm(code, out);
+            written = out.good() && file.close();
+        }
+
+        if(!written) {
+            fprintf(stderr, "Error: Could not write output file %s\n", output.c_str());
+            return 1;
+        }
+    }
+
+    printf("%zu functions, %zu bytes of source, %zu bytes of assembly\n", functions, size, bytes);
+    printf("best of %d runs: %.3f ms, %.1f MB/s\n", runs, best * 1000, bytes / best / 1e6);
+
+    return 0;
+}
@@ -0,0 +1,439 @@
+#include "cfg.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+bool Loop::contains(BasicBlock* b) const {
+    return std::find(blocks.begin(), blocks.end(), b) != blocks.end();
+}
+
+CFG::~CFG() {
+    for(Loop* loop : loops)
+        delete loop;
+
+    for(BasicBlock* block : blocks)
+        delete block;
+}
+
+bool CFG::dominates(BasicBlock* a, BasicBlock* b) const {
+    if(!a->reachable() || !b->reachable())
+        return false;
+
+    for(BasicBlock* cur = b; cur != nullptr; cur = cur->idom) {
+        if(cur == a)
+            return true;
+    }
+
+    return false;
+}
+
+static BasicBlock* newBlock(CFG* cfg, TAC* first) {
+    BasicBlock* block = new BasicBlock{static_cast<int>(cfg->blocks.size()), first, first};
+    cfg->blocks.push_back(block);
+    return block;
+}
+
+static void addEdge(BasicBlock* from, BasicBlock* to) {
+    if(std::find(from->succs.begin(), from->succs.end(), to) != from->succs.end())
+        return;
+
+    from->succs.push_back(to);
+    to->preds.push_back(from);
+}
+
+static bool endsBlock(TAC* t) {
+    return t->type == TACType::JUMP || t->type == TACType::IFZ || t->type == TACType::RET;
+}
+
+static void computeRPO(CFG* cfg) {
+    std::vector<BasicBlock*> postorder;
+    std::vector<bool> visited(cfg->blocks.size(), false);
+    std::vector<std::pair<BasicBlock*, size_t>> stack;
+
+    for(BasicBlock* b : cfg->blocks)
+        b->rpo = -1;
+
+    stack.push_back({cfg->entry(), 0});
+    visited[cfg->entry()->id] = true;
+
+    while(!stack.empty()) {
+        BasicBlock* b = stack.back().first;
+        size_t& next = stack.back().second;
+
+        if(next < b->succs.size()) {
+            BasicBlock* s = b->succs[next++];
+            if(!visited[s->id]) {
+                visited[s->id] = true;
+                stack.push_back({s, 0});
+            }
+        } else {
+            postorder.push_back(b);
+            stack.pop_back();
+        }
+    }
+
+    cfg->rpo.assign(postorder.rbegin(), postorder.rend());
+    for(size_t i = 0; i < cfg->rpo.size(); i++)
+        cfg->rpo[i]->rpo = static_cast<int>(i);
+}
+
+CFG* buildCFG(TAC* beginFun) {
+    if(!beginFun || beginFun->type != TACType::BEGINFUN)
+        throw std::runtime_error("CFG must start at a BEGINFUN");
+
+    CFG* cfg = new CFG();
+    cfg->func = beginFun->res;
+
+    newBlock(cfg, beginFun);
+
+    std::map<Symbol*, BasicBlock*> labelBlock;
+    BasicBlock* cur = nullptr;
+    TAC* t;
+
+    for(t = beginFun->next; t && t->type != TACType::ENDFUN; t = t->next) {
+        if(!cur || t->type == TACType::LABEL)
+            cur = newBlock(cfg, t);
+
+        cur->last = t;
+
+        if(t->type == TACType::LABEL)
+            labelBlock[t->res] = cur;
+
+        if(endsBlock(t))
+            cur = nullptr;
+    }
+
+    if(!t)
+        throw std::runtime_error("Function " + cfg->func->content + " has no ENDFUN");
+
+    newBlock(cfg, t);
+
+    std::vector<BasicBlock*>& blocks = cfg->blocks;
+    addEdge(blocks[0], blocks[1]);
+
+    for(size_t i = 1; i + 1 < blocks.size(); i++) {
+        TAC* last = blocks[i]->last;
+
+        switch(last->type) {
+            case TACType::JUMP:
+            case TACType::IFZ: {
+                auto it = labelBlock.find(last->res);
+                if(it == labelBlock.end())
+                    throw std::runtime_error("Jump to unknown label " + last->res->content);
+
+                addEdge(blocks[i], it->second);
+
+                if(last->type == TACType::IFZ)
+                    addEdge(blocks[i], blocks[i + 1]);
+
+                break;
+            }
+
+            case TACType::RET:
+                addEdge(blocks[i], cfg->exit());
+                break;
+
+            default:
+                addEdge(blocks[i], blocks[i + 1]);
+                break;
+        }
+    }
+
+    computeRPO(cfg);
+    computeDominators(cfg);
+    findLoops(cfg);
+
+    return cfg;
+}
+
+std::vector<CFG*> buildAllCFGs(const TACList& list) {
+    std::vector<CFG*> cfgs;
+
+    for(TAC* t = list.head; t != nullptr; t = t->next) {
+        if(t->type == TACType::BEGINFUN)
+            cfgs.push_back(buildCFG(t));
+    }
+
+    return cfgs;
+}
+
+void freeCFGs(std::vector<CFG*>& cfgs) {
+    for(CFG* cfg : cfgs)
+        delete cfg;
+
+    cfgs.clear();
+}
+
+static BasicBlock* intersect(BasicBlock* b1, BasicBlock* b2) {
+    while(b1 != b2) {
+        while(b1->rpo > b2->rpo) b1 = b1->idom;
+        while(b2->rpo > b1->rpo) b2 = b2->idom;
+    }
+
+    return b1;
+}
+
+// Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm"
+void computeDominators(CFG* cfg) {
+    for(BasicBlock* b : cfg->blocks) {
+        b->idom = nullptr;
+        b->domChildren.clear();
+    }
+
+    BasicBlock* entry = cfg->entry();
+    entry->idom = entry;
+
+    bool changed = true;
+    while(changed) {
+        changed = false;
+
+        for(size_t i = 1; i < cfg->rpo.size(); i++) {
+            BasicBlock* b = cfg->rpo[i];
+            BasicBlock* newIdom = nullptr;
+
+            for(BasicBlock* p : b->preds) {
+                if(!p->idom)
+                    continue;
+
+                newIdom = newIdom ? intersect(p, newIdom) : p;
+            }
+
+            if(newIdom != b->idom) {
+                b->idom = newIdom;
+                changed = true;
+            }
+        }
+    }
+
+    entry->idom = nullptr;
+
+    for(BasicBlock* b : cfg->rpo) {
+        if(b->idom)
+            b->idom->domChildren.push_back(b);
+    }
+
+    // Dominance frontiers, from the same paper
+    for(BasicBlock* b : cfg->blocks)
+        b->domFrontier.clear();
+
+    for(BasicBlock* b : cfg->rpo) {
+        if(b->preds.size() < 2)
+            continue;
+
+        for(BasicBlock* p : b->preds) {
+            if(!p->reachable())
+                continue;
+
+            for(BasicBlock* runner = p; runner != nullptr && runner != b->idom; runner = runner->idom) {
+                if(std::find(runner->domFrontier.begin(), runner->domFrontier.end(), b) == runner->domFrontier.end())
+                    runner->domFrontier.push_back(b);
+            }
+        }
+    }
+}
+
+void findLoops(CFG* cfg) {
+    for(Loop* loop : cfg->loops)
+        delete loop;
+    cfg->loops.clear();
+
+    std::map<BasicBlock*, Loop*> byHeader;
+
+    for(BasicBlock* b : cfg->rpo) {
+        b->loopDepth = 0;
+
+        for(BasicBlock* s : b->succs) {
+            if(!cfg->dominates(s, b))
+                continue;
+
+            // b -> s is a back edge
+            Loop*& loop = byHeader[s];
+            if(!loop) {
+                loop = new Loop{s};
+                loop->blocks.push_back(s);
+                cfg->loops.push_back(loop);
+            }
+
+            loop->latches.push_back(b);
+
+            std::vector<BasicBlock*> work = {b};
+            while(!work.empty()) {
+                BasicBlock* cur = work.back();
+                work.pop_back();
+
+                if(loop->contains(cur))
+                    continue;
+
+                loop->blocks.push_back(cur);
+                for(BasicBlock* p : cur->preds)
+                    if(p->reachable())
+                        work.push_back(p);
+            }
+        }
+    }
+
+    std::stable_sort(cfg->loops.begin(), cfg->loops.end(), [](Loop* a, Loop* b) {
+        return a->blocks.size() < b->blocks.size();
+    });
+
+    // The parent is the smallest loop around the header
+    for(size_t i = 0; i < cfg->loops.size(); i++) {
+        for(size_t j = i + 1; j < cfg->loops.size(); j++) {
+            if(cfg->loops[j]->contains(cfg->loops[i]->header)) {
+                cfg->loops[i]->parent = cfg->loops[j];
+                break;
+            }
+        }
+    }
+
+    for(Loop* loop : cfg->loops) {
+        loop->depth = 1;
+        for(Loop* p = loop->parent; p != nullptr; p = p->parent)
+            loop->depth++;
+
+        for(BasicBlock* b : loop->blocks)
+            b->loopDepth++;
+    }
+}
+
+static void replaceBlock(std::vector<BasicBlock*>& blocks, BasicBlock* from, BasicBlock* to) {
+    std::replace(blocks.begin(), blocks.end(), from, to);
+}
+
+BasicBlock* getPreheader(CFG* cfg, Loop* loop, TACList& list) {
+    BasicBlock* header = loop->header;
+    BasicBlock* outside = nullptr;
+
+    for(BasicBlock* p : header->preds) {
+        if(!p->reachable() || loop->contains(p))
+            continue;
+
+        if(outside)
+            return nullptr;
+        outside = p;
+    }
+
+    if(!outside || header->first->type != TACType::LABEL)
+        return nullptr;
+
+    if(outside != cfg->entry() && outside->succs.size() == 1)
+        return outside;
+
+    // The new block goes right before the header, so the block before it must not fall through into the header
+    BasicBlock* before = cfg->blocks[header->id - 1];
+    TAC* beforeLast = before->last;
+    bool fallsThrough = beforeLast->type != TACType::JUMP && beforeLast->type != TACType::RET;
+
+    if(before != outside && fallsThrough && std::find(header->preds.begin(), header->preds.end(), before) != header->preds.end())
+        return nullptr;
+
+    TAC* label = new TAC(TACType::LABEL, makeLabel());
+    tacInsertBefore(list, header->first, label);
+
+    TAC* outsideLast = outside->last;
+    if(outside != before && (outsideLast->type == TACType::JUMP || outsideLast->type == TACType::IFZ) && outsideLast->res == header->first->res)
+        outsideLast->res = label->res;
+
+    BasicBlock* pre = new BasicBlock{0, label, label};
+    cfg->blocks.insert(cfg->blocks.begin() + header->id, pre);
+    for(size_t i = 0; i < cfg->blocks.size(); i++)
+        cfg->blocks[i]->id = static_cast<int>(i);
+
+    cfg->rpo.insert(cfg->rpo.begin() + header->rpo, pre);
+    for(size_t i = 0; i < cfg->rpo.size(); i++)
+        cfg->rpo[i]->rpo = static_cast<int>(i);
+
+    replaceBlock(outside->succs, header, pre);
+    replaceBlock(header->preds, outside, pre); // Same position, so the phi operands still line up
+    pre->preds = {outside};
+    pre->succs = {header};
+
+    pre->idom = header->idom;
+    replaceBlock(pre->idom->domChildren, header, pre);
+    pre->domChildren = {header};
+    header->idom = pre;
+
+    for(Loop* outer = loop->parent; outer != nullptr; outer = outer->parent)
+        outer->blocks.push_back(pre);
+    pre->loopDepth = header->loopDepth - 1;
+
+    return pre;
+}
+
+void appendToBlock(TACList& list, BasicBlock* b, TAC* t) {
+    TAC* last = b->last;
+
+    if(last->type == TACType::JUMP || last->type == TACType::IFZ || last->type == TACType::RET) {
+        tacInsertBefore(list, last, t);
+        if(b->first == last)
+            b->first = t;
+    } else {
+        tacInsertAfter(list, last, t);
+        b->last = t;
+    }
+}
+
+static std::string dotEscape(const std::string& text) {
+    std::string res;
+
+    for(char c : text) {
+        if(c == '"' || c == '\\')
+            res += '\\';
+        res += c;
+    }
+
+    return res;
+}
+
+static std::string dotNode(CFG* cfg, BasicBlock* b) {
+    return "\"" + dotEscape(cfg->func->content) + "_B" + std::to_string(b->id) + "\"";
+}
+
+void dumpCFG(std::ostream& out, const std::vector<CFG*>& cfgs) {
+    out << "digraph CFG {\n"
+           "\tnode [shape=box, fontname=\"monospace\"];\n";
+
+    for(CFG* cfg : cfgs) {
+        std::map<BasicBlock*, bool> isHeader;
+        for(Loop* loop : cfg->loops)
+            isHeader[loop->header] = true;
+
+        out << "\tsubgraph \"cluster_" << dotEscape(cfg->func->content) << "\" {\n"
+               "\t\tlabel=\"" << dotEscape(cfg->func->content) << "\";\n";
+
+        for(BasicBlock* b : cfg->blocks) {
+            out << "\t\t" << dotNode(cfg, b) << " [label=\"B" << b->id;
+
+            if(b->idom)
+                out << " (idom B" << b->idom->id << ")";
+            if(b->loopDepth > 0)
+                out << " depth " << b->loopDepth;
+
+            out << "\\l";
+            for(TAC* t = b->first; t != nullptr; t = b->next(t))
+                out << dotEscape(tacToString(t)) << "\\l";
+            out << "\"";
+
+            if(!b->reachable())
+                out << ", style=dashed";
+            else if(isHeader[b])
+                out << ", color=blue, penwidth=2";
+
+            out << "];\n";
+        }
+
+        for(BasicBlock* b : cfg->blocks) {
+            for(BasicBlock* s : b->succs) {
+                out << "\t\t" << dotNode(cfg, b) << " -> " << dotNode(cfg, s);
+                if(cfg->dominates(s, b))
+                    out << " [color=red, style=bold]";
+                out << ";\n";
+            }
+        }
+
+        out << "\t}\n";
+    }
+
+    out << "}\n";
+}
@@ -0,0 +1,84 @@
+#ifndef CFG_COMP
+#define CFG_COMP
+
+#include "../tacs/tacs.h"
+
+#include <vector>
+#include <ostream>
+
+// Straight line run of TACs, [first, last] inside the TAC list
+struct BasicBlock {
+    int id;
+    TAC* first;
+    TAC* last;
+
+    std::vector<BasicBlock*> preds;
+    std::vector<BasicBlock*> succs;
+
+    // Dominator tree
+    BasicBlock* idom = nullptr;
+    std::vector<BasicBlock*> domChildren;
+    std::vector<BasicBlock*> domFrontier;
+
+    int rpo = -1; // Position in reverse postorder, -1 if unreachable
+    int loopDepth = 0;
+
+    bool reachable() const { return rpo >= 0; }
+
+    // Walks the block: for(TAC* t = b->first; t; t = b->next(t))
+    TAC* next(TAC* t) const { return t == last ? nullptr : t->next; }
+};
+
+// Natural loop, the union of the bodies of all back edges into header
+struct Loop {
+    BasicBlock* header;
+    std::vector<BasicBlock*> blocks; // Includes the header
+    std::vector<BasicBlock*> latches; // Sources of the back edges
+    Loop* parent = nullptr;
+    int depth = 1;
+
+    bool contains(BasicBlock* b) const;
+};
+
+// Control flow graph of a single function. blocks[0] only holds the BEGINFUN and blocks.back() only the ENDFUN,
+// so the function always has a single entry and a single exit.
+// The blocks point into the TAC list, so the CFG has to be built again after the code changes
+struct CFG {
+    Symbol* func;
+    std::vector<BasicBlock*> blocks;
+    std::vector<BasicBlock*> rpo;
+    std::vector<Loop*> loops; // Inner loops come before the loops that contain them
+
+    CFG() = default;
+    CFG(const CFG&) = delete;
+    CFG& operator=(const CFG&) = delete;
+    ~CFG();
+
+    BasicBlock* entry() const { return blocks.front(); }
+    BasicBlock* exit() const { return blocks.back(); }
+
+    bool dominates(BasicBlock* a, BasicBlock* b) const;
+};
+
+// Builds the CFG of the function starting at beginFun, with dominators and loops
+CFG* buildCFG(TAC* beginFun);
+
+// One CFG per BEGINFUN..ENDFUN range of the list
+std::vector<CFG*> buildAllCFGs(const TACList& list);
+void freeCFGs(std::vector<CFG*>& cfgs);
+
+void computeDominators(CFG* cfg);
+void findLoops(CFG* cfg);
+
+// Block that only runs right before entering the loop, it is created between the single predecessor from outside the loop
+// and the header when there isn't one yet (dominators, RPO and loops are kept up to date, dominance frontiers are not).
+// nullptr when the loop is entered from more than one block
+BasicBlock* getPreheader(CFG* cfg, Loop* loop, TACList& list);
+
+// Adds t at the end of the block, before the jump that ends it
+void appendToBlock(TACList& list, BasicBlock* b, TAC* t);
+
+// Graphviz export, one cluster per function
+void dumpCFG(std::ostream& out, const std::vector<CFG*>& cfgs);
+
+#endif /* CFG_COMP */
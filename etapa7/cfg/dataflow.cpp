@@ -0,0 +1,113 @@
+#include "dataflow.h"
+
+#include <set>
+
+BitVector::BitVector(size_t size, bool value) : bits(size), words((size + 63) / 64, value ? ~uint64_t(0) : 0) {
+    // The padding of the last word stays clear, so equal sets have equal words
+    if(value && size % 64)
+        words.back() = (uint64_t(1) << (size % 64)) - 1;
+}
+
+bool BitVector::unite(const BitVector& other) {
+    bool changed = false;
+
+    for(size_t i = 0; i < words.size(); i++) {
+        uint64_t w = words[i] | other.words[i];
+        changed |= w != words[i];
+        words[i] = w;
+    }
+
+    return changed;
+}
+
+bool BitVector::intersect(const BitVector& other) {
+    bool changed = false;
+
+    for(size_t i = 0; i < words.size(); i++) {
+        uint64_t w = words[i] & other.words[i];
+        changed |= w != words[i];
+        words[i] = w;
+    }
+
+    return changed;
+}
+
+bool BitVector::subtract(const BitVector& other) {
+    bool changed = false;
+
+    for(size_t i = 0; i < words.size(); i++) {
+        uint64_t w = words[i] & ~other.words[i];
+        changed |= w != words[i];
+        words[i] = w;
+    }
+
+    return changed;
+}
+
+DataflowProblem::DataflowProblem(CFG* cfg, DataflowDirection direction, DataflowMeet meet, size_t size)
+    : direction(direction), meet(meet), size(size),
+      gen(cfg->blocks.size(), BitVector(size)), kill(cfg->blocks.size(), BitVector(size)), boundary(size) {}
+
+DataflowResult solveDataflow(CFG* cfg, const DataflowProblem& problem) {
+    bool forward = problem.direction == DataflowDirection::Forward;
+    bool isUnion = problem.meet == DataflowMeet::Union;
+
+    // Seen from the problem, "before" is where the meet happens and "after" is what the transfer produces
+    DataflowResult result;
+    result.in.assign(cfg->blocks.size(), BitVector(problem.size, !isUnion));
+    result.out.assign(cfg->blocks.size(), BitVector(problem.size, !isUnion));
+    std::vector<BitVector>& before = forward ? result.in : result.out;
+    std::vector<BitVector>& after = forward ? result.out : result.in;
+
+    std::vector<BasicBlock*> order = cfg->rpo;
+    if(!forward)
+        order.assign(cfg->rpo.rbegin(), cfg->rpo.rend());
+
+    std::vector<int> position(cfg->blocks.size(), -1);
+    for(size_t i = 0; i < order.size(); i++)
+        position[order[i]->id] = i;
+
+    BasicBlock* boundaryBlock = forward ? cfg->entry() : cfg->exit();
+
+    // Ordered by position, so each round goes through the blocks in the order of the problem
+    std::set<int> worklist;
+    for(size_t i = 0; i < order.size(); i++)
+        worklist.insert(i);
+
+    while(!worklist.empty()) {
+        BasicBlock* b = order[*worklist.begin()];
+        worklist.erase(worklist.begin());
+
+        const std::vector<BasicBlock*>& sources = forward ? b->preds : b->succs;
+        const std::vector<BasicBlock*>& targets = forward ? b->succs : b->preds;
+
+        BitVector value(problem.size, !isUnion);
+        if(b == boundaryBlock)
+            value = problem.boundary;
+
+        for(BasicBlock* s : sources) {
+            if(position[s->id] < 0)
+                continue;
+
+            if(isUnion)
+                value.unite(after[s->id]);
+            else
+                value.intersect(after[s->id]);
+        }
+
+        before[b->id] = value;
+        value.subtract(problem.kill[b->id]);
+        value.unite(problem.gen[b->id]);
+
+        if(value == after[b->id])
+            continue;
+
+        after[b->id] = value;
+
+        for(BasicBlock* t : targets)
+            if(position[t->id] >= 0)
+                worklist.insert(position[t->id]);
+    }
+
+    return result;
+}
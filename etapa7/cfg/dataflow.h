@@ -0,0 +1,101 @@
+#ifndef DATAFLOW_COMP
+#define DATAFLOW_COMP
+
+#include "cfg.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Fixed size set of small integers, one bit each
+class BitVector {
+    public:
+        BitVector(size_t size = 0, bool value = false);
+
+        size_t size() const { return bits; }
+
+        bool test(size_t i) const { return words[i / 64] >> (i % 64) & 1; }
+        void set(size_t i) { words[i / 64] |= uint64_t(1) << (i % 64); }
+        void reset(size_t i) { words[i / 64] &= ~(uint64_t(1) << (i % 64)); }
+
+        // The set operations return whether this set changed
+        bool unite(const BitVector& other);
+        bool intersect(const BitVector& other);
+        bool subtract(const BitVector& other);
+
+        bool operator==(const BitVector& other) const { return words == other.words; }
+        bool operator!=(const BitVector& other) const { return words != other.words; }
+
+    private:
+        size_t bits;
+        std::vector<uint64_t> words;
+};
+
+// Dense ids for the symbols or TACs of one function, so they can index a BitVector
+template<typename T>
+struct Numbering {
+    std::unordered_map<T*, int> ids;
+    std::vector<T*> items;
+
+    int add(T* item) {
+        auto it = ids.find(item);
+        if(it != ids.end())
+            return it->second;
+
+        ids[item] = items.size();
+        items.push_back(item);
+        return items.size() - 1;
+    }
+
+    // -1 when the item was never numbered
+    int id(T* item) const {
+        auto it = ids.find(item);
+        return it == ids.end() ? -1 : it->second;
+    }
+
+    size_t size() const { return items.size(); }
+};
+
+typedef Numbering<Symbol> SymbolNumbering;
+typedef Numbering<TAC> TACNumbering;
+
+enum class DataflowDirection { Forward, Backward };
+enum class DataflowMeet { Union, Intersection };
+
+// Bit-vector problem in gen/kill form: out = gen U (in - kill) for forward problems, and the other way around
+// for backward ones. gen and kill are indexed by block id
+struct DataflowProblem {
+    DataflowDirection direction;
+    DataflowMeet meet;
+    size_t size;
+
+    std::vector<BitVector> gen;
+    std::vector<BitVector> kill;
+    BitVector boundary; // Value at the entry (forward) or at the exit (backward)
+
+    DataflowProblem(CFG* cfg, DataflowDirection direction, DataflowMeet meet, size_t size);
+};
+
+// in and out are in the direction of the code, whatever the direction of the problem. Indexed by block id,
+// unreachable blocks keep the initial value (empty for unions, full for intersections)
+struct DataflowResult {
+    std::vector<BitVector> in;
+    std::vector<BitVector> out;
+};
+
+// Worklist solver, the blocks are visited in reverse postorder (forward) or its reverse (backward)
+DataflowResult solveDataflow(CFG* cfg, const DataflowProblem& problem);
+
+// Variables (globals, locals and temps) live at the start and at the end of each block
+struct Liveness {
+    SymbolNumbering vars;
+    DataflowResult sets;
+};
+
+Liveness computeLiveness(CFG* cfg);
+
+// Deletes the assignments whose result is overwritten or thrown away before anything reads it,
+// returns how many TACs were removed
+int removeDeadStores(TACList& list);
+
+#endif /* DATAFLOW_COMP */
@@ -0,0 +1,146 @@
+#include "dataflow.h"
+
+// Scalars that can hold a value between two TACs. Vectors are only stored element by element, so they are never dead
+static bool isVariable(Symbol* sym) {
+    if(!sym)
+        return false;
+
+    return sym->symType == SymbolType::VarId || sym->symType == SymbolType::Local || sym->symType == SymbolType::Temp;
+}
+
+// The caller may read the globals after the function returns, and so may any function it calls
+static bool isGlobalVariable(Symbol* sym) {
+    return isVariable(sym) && !sym->isFunctionScoped();
+}
+
+static bool exposesGlobals(TAC* t) {
+    return t->type == TACType::CALL || t->type == TACType::RET || t->type == TACType::ENDFUN;
+}
+
+// Assignments that only write their result
+static bool isDeadStoreCandidate(TAC* t) {
+    switch(t->type) {
+        case TACType::ADD: case TACType::SUB: case TACType::MUL: case TACType::DIV: case TACType::MOD:
+        case TACType::LESS: case TACType::GREATER: case TACType::LESSEQUAL: case TACType::GREATEREQUAL:
+        case TACType::EQUAL: case TACType::NOTEQUAL: case TACType::AND: case TACType::OR:
+        case TACType::NOT: case TACType::LSHIFT: case TACType::RSHIFT:
+        case TACType::MOVE: case TACType::VECACCESS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Live set right before t, given the set right after it
+static void transfer(TAC* t, BitVector& live, const Liveness& liveness, const BitVector& globals) {
+    if(Symbol* def = tacDef(t))
+        if(isVariable(def))
+            live.reset(liveness.vars.id(def));
+
+    if(exposesGlobals(t))
+        live.unite(globals);
+
+    for(Symbol* use : tacUses(t))
+        if(isVariable(use))
+            live.set(liveness.vars.id(use));
+}
+
+static BitVector globalsOf(const Liveness& liveness) {
+    BitVector globals(liveness.vars.size());
+
+    for(size_t i = 0; i < liveness.vars.size(); i++)
+        if(isGlobalVariable(liveness.vars.items[i]))
+            globals.set(i);
+
+    return globals;
+}
+
+Liveness computeLiveness(CFG* cfg) {
+    Liveness liveness;
+
+    for(BasicBlock* b : cfg->blocks) {
+        for(TAC* t = b->first; t; t = b->next(t)) {
+            if(isVariable(tacDef(t)))
+                liveness.vars.add(tacDef(t));
+
+            for(Symbol* use : tacUses(t))
+                if(isVariable(use))
+                    liveness.vars.add(use);
+        }
+    }
+
+    BitVector globals = globalsOf(liveness);
+    DataflowProblem problem(cfg, DataflowDirection::Backward, DataflowMeet::Union, liveness.vars.size());
+
+    // gen are the upward exposed uses and kill the definitions, collected from the end of the block
+    for(BasicBlock* b : cfg->rpo) {
+        BitVector& gen = problem.gen[b->id];
+        BitVector& kill = problem.kill[b->id];
+
+        for(TAC* t = b->last; ; t = t->prev) {
+            Symbol* def = tacDef(t);
+            if(isVariable(def)) {
+                kill.set(liveness.vars.id(def));
+                gen.reset(liveness.vars.id(def));
+            }
+
+            transfer(t, gen, liveness, globals);
+
+            if(t == b->first)
+                break;
+        }
+    }
+
+    liveness.sets = solveDataflow(cfg, problem);
+    return liveness;
+}
+
+// Walks each block backwards from its live out set and drops the assignments to variables that are dead at that point
+static int removeDeadStores(TACList& list, CFG* cfg) {
+    Liveness liveness = computeLiveness(cfg);
+    BitVector globals = globalsOf(liveness);
+    std::vector<TAC*> dead;
+
+    for(BasicBlock* b : cfg->rpo) {
+        BitVector live = liveness.sets.out[b->id];
+
+        for(TAC* t = b->last; ; t = t->prev) {
+            TAC* prev = t == b->first ? nullptr : t->prev;
+
+            if(isDeadStoreCandidate(t) && isVariable(t->res) && !live.test(liveness.vars.id(t->res)))
+                dead.push_back(t);
+            else
+                transfer(t, live, liveness, globals);
+
+            if(!prev)
+                break;
+        }
+    }
+
+    for(TAC* t : dead)
+        tacErase(list, t);
+
+    return dead.size();
+}
+
+int removeDeadStores(TACList& list) {
+    int removed = 0;
+
+    // Removing a store may kill the stores that fed it in other blocks, the CFGs have to be built again for that
+    while(true) {
+        std::vector<CFG*> cfgs = buildAllCFGs(list);
+        int round = 0;
+
+        for(CFG* cfg : cfgs)
+            round += removeDeadStores(list, cfg);
+
+        freeCFGs(cfgs);
+
+        if(round == 0)
+            break;
+
+        removed += round;
+    }
+
+    return removed;
+}
@@ -0,0 +1,134 @@
+#include "context.h"
+#include "../lexer/lexer.h"
+#include "../driver/thread_pool.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+static thread_local CompilationContext* current = nullptr;
+static thread_local FunctionContext* currentFunc = nullptr;
+
+CompilationContext::~CompilationContext() {
+    stopScanner(*this);
+
+    // The TACs and the AST point to the symbols, so they go first
+    for(auto& function : functions)
+        function->tacArena.release();
+
+    tacArena.release();
+    ast.clear();
+
+    for(auto& function : functions)
+        function->symbolArena.release();
+
+    symbolArena.release();
+}
+
+FunctionContext::~FunctionContext() {
+    tacArena.release();
+    symbolArena.release();
+}
+
+CompilationContext& context() {
+    if(!current) {
+        fprintf(stderr, "No compilation context bound to this thread\n");
+        abort();
+    }
+
+    return *current;
+}
+
+ContextScope::ContextScope(CompilationContext& ctx) : previous(current) {
+    current = &ctx;
+}
+
+ContextScope::~ContextScope() {
+    current = previous;
+}
+
+FunctionContext* currentFunction() {
+    return currentFunc;
+}
+
+FunctionScope::FunctionScope(FunctionContext& function) : unit(function.unit), previous(currentFunc) {
+    currentFunc = &function;
+}
+
+FunctionScope::~FunctionScope() {
+    currentFunc = previous;
+}
+
+std::ostream& output() {
+    return currentFunc ? currentFunc->out : *context().out;
+}
+
+void splitFunctions(TACList& list) {
+    CompilationContext& ctx = context();
+    size_t count = 0;
+
+    for(TAC* t = list.head; t;) {
+        TAC* start = t;
+        while(t->next && t->type != TACType::ENDFUN)
+            t = t->next;
+
+        TAC* end = t;
+        t = t->next;
+
+        start->prev = nullptr;
+        end->next = nullptr;
+
+        if(count == ctx.functions.size())
+            ctx.functions.emplace_back(new FunctionContext(ctx, count));
+
+        ctx.functions[count++]->code = TACList(start, end);
+    }
+
+    // The passes never remove a BEGINFUN or an ENDFUN, but the global TACs after the last function may be gone
+    for(size_t i = count; i < ctx.functions.size(); i++)
+        ctx.functions[i]->code = TACList();
+
+    list = TACList();
+}
+
+TACList joinFunctions() {
+    TACList list;
+
+    for(auto& function : context().functions) {
+        list = tacJoin(list, function->code);
+        function->code = TACList();
+    }
+
+    return list;
+}
+
+void forEachFunction(const std::function<void(FunctionContext&)>& work) {
+    CompilationContext& ctx = context();
+    std::vector<std::exception_ptr> errors(ctx.functions.size());
+
+    auto run = [&](size_t i) {
+        FunctionScope scope(*ctx.functions[i]);
+
+        try {
+            work(*ctx.functions[i]);
+        } catch(...) {
+            errors[i] = std::current_exception();
+        }
+    };
+
+    if(ctx.pool) {
+        ThreadPool::TaskGroup group;
+
+        for(size_t i = 0; i < ctx.functions.size(); i++)
+            ctx.pool->submit([&run, i]() { run(i); }, group);
+
+        ctx.pool->wait(group);
+    } else {
+        for(size_t i = 0; i < ctx.functions.size(); i++)
+            run(i);
+    }
+
+    for(std::exception_ptr& error : errors)
+        if(error)
+            std::rethrow_exception(error);
+}
@@ -0,0 +1,187 @@
+#ifndef CONTEXT_COMP
+#define CONTEXT_COMP
+
+#include "../tacs/tacs.h"
+#include "../passes/passes.h"
+#include "../symbols/interner.h"
+#include "../memory/arena.h"
+#include "../asm/asm_writer.h"
+
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+class FunctionContext;
+
+// Where the hand written lexer (lexer/lexer.cpp) is in the source
+struct HandLexerState {
+    bool active = false;
+    const char* cursor = nullptr;
+    const char* end = nullptr;
+    const char* tokenStart = nullptr;
+    size_t tokenLength = 0;
+};
+
+// Everything the compilation of one source file changes: the scanner and parser state, the AST, the symbols,
+// the arenas of the symbols and TACs and what the backend and the pass timers keep between functions.
+// The parser and the scanners get it as a parameter, the rest of the compiler through context(), so units
+// compiled by different threads don't share anything. The optimizer and the backend work on each function
+// with a FunctionContext of its own, so the functions of a unit can be done by different threads too
+class CompilationContext {
+    public:
+        explicit CompilationContext(const PassOptions& options = PassOptions())
+            : options(options), passes(resolvePassFlags(options)) {}
+        ~CompilationContext();  // Frees the whole unit at once, the scanner included
+
+        CompilationContext(const CompilationContext&) = delete;
+        CompilationContext& operator=(const CompilationContext&) = delete;
+
+        // Where the messages of the unit go: syntax and semantic errors and the TAC dumps
+        std::ostream* out = &std::cout;
+
+        // Where the functions are optimized and emitted (forEachFunction), on the calling thread when null
+        ThreadPool* pool = nullptr;
+
+        // Scanner and parser (scanner.l, lexer/, parser.ypp)
+        void* scanner = nullptr;    // yyscan_t of the reentrant flex scanner
+        HandLexerState handLexer;
+        bool running = true;        // Until a scanner reaches the end of the source
+        int lineNumber = 1;
+        int syntaxErrors = 0;
+        ASTNodeId root = NoNode;
+
+        AST ast;
+
+        // Symbols (symbols/symbols.cpp). The table is indexed by the id of the name in the interner, nullptr for
+        // names that were removed. Temps, labels and SSA versions are made up by the compiler and nobody looks
+        // them up, so they only go to generated. The passes add literals while the functions run, symbolsLock
+        // keeps the table and the interner whole
+        std::mutex symbolsLock;
+        StringInterner names;
+        std::vector<Symbol*> symbolsTable;
+        std::vector<Symbol*> generated;
+        std::unordered_map<int, Symbol*> integerLiterals;   // makeLiteral, so folding doesn't format the value to find it
+        int tempCount = 0;
+        int labelCount = 0;
+        int versionCount = 0;
+
+        Arena<Symbol> symbolArena;
+        Arena<TAC> tacArena;
+
+        // Temps the generated code keeps in memory, they get a slot in the data section (asm/)
+        std::map<Symbol*, bool> usedTemps;
+
+        // Pass options of the unit and the passes they turn on (passes/)
+        const PassOptions options;
+        const PassFlags passes;
+
+        // --time-passes (passes/)
+        std::vector<std::string> timedOrder;
+        std::map<std::string, PassTime> passTimes;
+
+        // Constants of the whole program the ssa pass gives every function (ssa/ssa_opt.cpp)
+        std::map<Symbol*, Symbol*> constantGlobals;
+
+        // The TAC list cut at the end of each function, in source order (splitFunctions)
+        std::vector<std::unique_ptr<FunctionContext>> functions;
+};
+
+// Symbol made by the compiler while a function was worked on, it is named for good once every function is done
+// (nameGeneratedSymbols), so the numbers come out in source order whatever thread made it
+struct GeneratedSymbol {
+    Symbol* symbol;
+    Symbol* versionOf;  // SSA versions, nullptr for temps and labels
+};
+
+// What the optimizer and the backend change while they work on one function: its TACs, with the global TACs that
+// come before it, the arenas for what it creates, the symbols it made up, what it prints and its frame layout.
+// It is bound to the thread working on the function by a FunctionScope, and the unit takes everything back in
+// source order once all of them are done, so the output is the same with any number of threads
+class FunctionContext {
+    public:
+        FunctionContext(CompilationContext& unit, size_t index) : unit(unit), index(index) {}
+        ~FunctionContext();
+
+        FunctionContext(const FunctionContext&) = delete;
+        FunctionContext& operator=(const FunctionContext&) = delete;
+
+        CompilationContext& unit;
+        const size_t index;     // Position in the functions of the unit
+        TACList code;
+
+        // Messages of the passes, and the assembly of the function (asm/)
+        std::ostringstream out;
+        AsmBuffer assembly;
+
+        // What the function allocates, its objects deleted here are reused. The ones of the unit are only abandoned
+        Arena<Symbol> symbolArena;
+        Arena<TAC> tacArena;
+
+        std::vector<GeneratedSymbol> generated;
+
+        // Same as the ones of the unit, which gets them back in source order
+        std::map<Symbol*, bool> usedTemps;
+        std::vector<std::string> timedOrder;
+        std::map<std::string, PassTime> passTimes;
+
+        // Frame layout (asm/): offset from %rbp of the params and locals and the register the allocator gave to
+        // each value. Locals and params with the same name are the same symbol in every function, so they can't
+        // keep their own offset and register while another function is emitted
+        std::unordered_map<Symbol*, int> frameOffsets;
+        std::unordered_map<Symbol*, int> registers;
+        int firstLocalLabel = 0;   // Number of the first .L label of the function
+};
+
+// Context of the unit the calling thread is compiling, the one its innermost ContextScope bound
+CompilationContext& context();
+
+// Binds a context to the calling thread while it is alive
+class ContextScope {
+    public:
+        explicit ContextScope(CompilationContext& ctx);
+        ~ContextScope();
+
+        ContextScope(const ContextScope&) = delete;
+        ContextScope& operator=(const ContextScope&) = delete;
+
+    private:
+        CompilationContext* previous;
+};
+
+// Function the calling thread is working on, nullptr while it works on the whole unit
+FunctionContext* currentFunction();
+
+// Binds a function, and its unit, to the calling thread while it is alive
+class FunctionScope {
+    public:
+        explicit FunctionScope(FunctionContext& function);
+        ~FunctionScope();
+
+        FunctionScope(const FunctionScope&) = delete;
+        FunctionScope& operator=(const FunctionScope&) = delete;
+
+    private:
+        ContextScope unit;
+        FunctionContext* previous;
+};
+
+// Where the compiler writes its messages: the buffer of the current function, or out of the unit
+std::ostream& output();
+
+// Cuts list after each ENDFUN into the functions of the unit (the global TACs after the last one make a piece
+// of their own), leaving list empty. joinFunctions puts the pieces back together in source order
+void splitFunctions(TACList& list);
+TACList joinFunctions();
+
+// Runs work for each function of the unit with it bound to the thread, on the pool of the unit when it has one.
+// An exception thrown by work comes out of here, the one of the first function in source order
+void forEachFunction(const std::function<void(FunctionContext&)>& work);
+
+#endif /* CONTEXT_COMP */
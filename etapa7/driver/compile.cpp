@@ -0,0 +1,204 @@
+#include "compile.h"
+#include "thread_pool.h"
+#include "../tacs/tacs.h"
+#include "../semantic_check/semantic_check.h"
+#include "../asm/asm.h"
+#include "../cfg/cfg.h"
+#include "../passes/passes.h"
+#include "../input/mapped_file.h"
+#include "../output/output_file.h"
+#include "../lexer/lexer.h"
+#include "../context/context.h"
+#include "../parser.tab.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+int compileFile(const CompileOptions& options, const std::string& input, const std::string& output,
+                std::ostream& out, std::ostream& err, ThreadPool* pool) {
+    // The source is scanned in place when it can be mapped, through yyin otherwise.
+    // The hand written lexer always works on memory, so it reads the files that can't be mapped
+    MappedFile source;
+    std::vector<char> contents;
+    std::unique_ptr<FILE, int(*)(FILE*)> in(nullptr, fclose);
+
+    // Everything the compilation of the file creates belongs to ctx
+    CompilationContext ctx(options.passes);
+    ContextScope scope(ctx);
+    ctx.out = &out;
+    ctx.pool = pool;
+
+    if(options.handLexer) {
+        if(options.mapInput && source.open(input, LexerPadding)) {
+            useHandLexer(ctx, source.data(), source.size());
+        } else {
+            std::ifstream file(input, std::ios::binary);
+            if(!file) {
+                err << "Didn't find the filename " << input << "\n";
+                return 2;
+            }
+
+            contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            size_t size = contents.size();
+            contents.resize(size + LexerPadding, '\0');
+            useHandLexer(ctx, contents.data(), size);
+        }
+    } else if(options.mapInput && source.open(input)) {
+        scanInPlace(ctx, source.data(), source.size());
+    } else {
+        in.reset(fopen(input.c_str(), "r"));
+        if(!in) {
+            err << "Didn't find the filename " << input << "\n";
+            return 2;
+        }
+
+        startScanner(ctx, in.get());
+    }
+
+    // Line, token and text of each token, for comparing the two lexers (lexdiff.sh)
+    if(options.dumpTokens) {
+        YYSTYPE value;
+        int tok;
+        while((tok = yylex(&value, ctx)) != 0)
+            out << ctx.lineNumber << " " << tok << " " << tokenText(ctx) << "\n";
+
+        return 0;
+    }
+
+    // yydebug = 1;
+    while(ctx.running) {
+        yyparse(ctx);
+    }
+
+    // ctx.ast.print(ctx.root);
+
+    if(ASTSemErrorCheck(ctx.root)) {
+        out << "\nExit 4\n";
+        return 4;
+    }
+
+    if(ctx.syntaxErrors > 0) {
+        err << "Compilation failed with " << ctx.syntaxErrors << " syntax errors.\n";
+        return 3;
+    }
+
+    // printSymbolsTable();
+    // tacPrintList(generateCode(ctx.root));
+
+    std::string outputFilename = output.empty() ? input + ".s" : output;
+
+    OutputFile asmFile;
+    if(!asmFile.open(outputFilename)) {
+        err << "Error: Could not open output file " << outputFilename << std::endl;
+        return 1;
+    }
+
+    TACList code = generateCode(ctx.root);
+
+    if(options.dumpCfg) {
+        std::string cfgFilename = options.cfgFilename.empty() ? input + ".dot" : options.cfgFilename;
+
+        std::ofstream dot(cfgFilename);
+        if(!dot.is_open()) {
+            err << "Error: Could not open output file " << cfgFilename << std::endl;
+            return 1;
+        }
+
+        std::vector<CFG*> cfgs = buildAllCFGs(code);
+        dumpCFG(dot, cfgs);
+        freeCFGs(cfgs);
+    }
+
+    // The assembly goes to the file while it is emitted, a function at a time
+    std::ostream asmOut(&asmFile);
+    generateAsm(code, asmOut);
+
+    if(!asmOut || !asmFile.close()) {
+        err << "Error: Could not write output file " << outputFilename << std::endl;
+        return 1;
+    }
+
+    printPassTimes(err);
+
+    // The whole unit goes away at once with the context, the arenas don't free object by object
+    return 0;
+}
+
+struct UnitResult {
+    int status = 0;
+    double ms = 0;
+};
+
+int compileFiles(const CompileOptions& options, const std::vector<std::string>& inputs, unsigned threads) {
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // A unit writing the file another one is reading (mapped, even) would break both
+    std::set<std::string> names(inputs.begin(), inputs.end());
+    for(const std::string& input : inputs) {
+        if(names.count(input + ".s") || names.size() != inputs.size()) {
+            std::cerr << "Each input must show up once and can't be the output (file_name.s) of another: " << input << "\n";
+            return 1;
+        }
+    }
+
+    std::vector<UnitResult> results(inputs.size());
+    std::mutex outputLock;
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        ThreadPool pool(threads);
+
+        for(size_t i = 0; i < inputs.size(); i++) {
+            pool.submit([&, i]() {
+                std::ostringstream out, err;
+                auto unitStart = std::chrono::steady_clock::now();
+
+                try {
+                    results[i].status = compileFile(options, inputs[i], "", out, err, &pool);
+                } catch(const std::exception& e) {
+                    err << inputs[i] << ": " << e.what() << "\n";
+                    results[i].status = 1;
+                }
+
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - unitStart;
+                results[i].ms = elapsed.count();
+
+                // The messages of a unit stay together, the units show up in the order they finish
+                std::lock_guard<std::mutex> guard(outputLock);
+                std::cout << out.str() << std::flush;
+                std::cerr << err.str() << std::flush;
+            });
+        }
+
+        pool.wait();
+    }
+
+    std::chrono::duration<double, std::milli> total = std::chrono::steady_clock::now() - start;
+    int worst = 0;
+
+    std::cerr << "===== Compilation times (" << threads << " threads) =====\n"
+              << std::left << std::setw(40) << "file" << std::right << std::setw(6) << "exit" << std::setw(12) << "time (ms)" << "\n";
+
+    for(size_t i = 0; i < inputs.size(); i++) {
+        worst = std::max(worst, results[i].status);
+
+        std::cerr << std::left << std::setw(40) << inputs[i] << std::right << std::setw(6) << results[i].status
+                  << std::setw(12) << std::fixed << std::setprecision(3) << results[i].ms << "\n";
+    }
+
+    std::cerr << std::left << std::setw(40) << "total" << std::right << std::setw(6) << worst
+              << std::setw(12) << total.count() << "\n";
+
+    return worst;
+}
@@ -0,0 +1,33 @@
+#ifndef COMPILE_COMP
+#define COMPILE_COMP
+
+#include "../passes/passes.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+struct CompileOptions {
+    bool dumpCfg = false;
+    std::string cfgFilename;    // input + ".dot" when empty
+    bool mapInput = true;
+    bool handLexer = false;
+    bool dumpTokens = false;
+    PassOptions passes;         // -O, --disable-pass and --time-passes, every unit gets a copy
+};
+
+// Compiles input into output (input + ".s" when it is empty) with a CompilationContext of its own. The messages of
+// the unit go to out and the errors about files and the pass times to err. With a pool its functions are optimized
+// and emitted on it, the output is the same. Returns the exit status for the unit: 0, 1 when an output can't be
+// written, 2 when the input can't be read, 3 for syntax and 4 for semantic errors
+int compileFile(const CompileOptions& options, const std::string& input, const std::string& output,
+                std::ostream& out, std::ostream& err, ThreadPool* pool = nullptr);
+
+// Driver for many inputs (-j N): compiles each one into input + ".s" on a pool of threads threads, one per core
+// when it is 0, which also gets the functions of the units. The messages of each unit are written together once
+// it is done, then a table with the status and time of every input. Returns the worst (highest) status
+int compileFiles(const CompileOptions& options, const std::vector<std::string>& inputs, unsigned threads);
+
+#endif /* COMPILE_COMP */
@@ -0,0 +1,143 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+// Pool and queue of the calling thread, when it is running a task
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local unsigned currentQueue = 0;
+
+ThreadPool::ThreadPool(unsigned threads) {
+    threads = std::max(threads, 1u);
+
+    for(unsigned i = 0; i < threads; i++)
+        queues.emplace_back(new Queue());
+
+    for(unsigned i = 0; i + 1 < threads; i++)
+        workers.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+
+    {
+        std::lock_guard<std::mutex> guard(stateLock);
+        stopping = true;
+    }
+    changed.notify_all();
+
+    for(std::thread& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    unsigned target = currentPool == this ? currentQueue : nextQueue++ % queues.size();
+    pending++;
+
+    {
+        std::lock_guard<std::mutex> guard(queues[target]->lock);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(stateLock);
+        queued++;
+    }
+    changed.notify_all();
+}
+
+void ThreadPool::submit(std::function<void()> task, TaskGroup& group) {
+    group.pending++;
+
+    submit([this, task = std::move(task), &group]() {
+        task();
+
+        // Whoever waits for the group sleeps on changed too
+        if(--group.pending == 0) {
+            std::lock_guard<std::mutex> guard(stateLock);
+            changed.notify_all();
+        }
+    });
+}
+
+bool ThreadPool::runOne(unsigned self) {
+    std::function<void()> task;
+
+    // Newest of its own queue first, it is the one most likely still in the cache
+    {
+        std::lock_guard<std::mutex> guard(queues[self]->lock);
+        if(!queues[self]->tasks.empty()) {
+            task = std::move(queues[self]->tasks.back());
+            queues[self]->tasks.pop_back();
+        }
+    }
+
+    // Then the oldest of the others, the biggest piece of work left in them
+    for(unsigned i = 1; !task && i < queues.size(); i++) {
+        Queue& victim = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+
+        if(!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+
+    if(!task)
+        return false;
+
+    queued--;
+
+    ThreadPool* previousPool = currentPool;
+    unsigned previousQueue = currentQueue;
+    currentPool = this;
+    currentQueue = self;
+
+    task();
+
+    currentPool = previousPool;
+    currentQueue = previousQueue;
+
+    if(--pending == 0) {
+        std::lock_guard<std::mutex> guard(stateLock);
+        changed.notify_all();
+    }
+
+    return true;
+}
+
+void ThreadPool::work(unsigned self) {
+    while(true) {
+        if(runOne(self))
+            continue;
+
+        std::unique_lock<std::mutex> lock(stateLock);
+        changed.wait(lock, [this]() { return stopping || queued > 0; });
+
+        if(stopping && queued == 0)
+            return;
+    }
+}
+
+void ThreadPool::wait() {
+    unsigned self = queues.size() - 1;
+
+    while(pending > 0) {
+        if(runOne(self))
+            continue;
+
+        std::unique_lock<std::mutex> lock(stateLock);
+        changed.wait(lock, [this]() { return pending == 0 || queued > 0; });
+    }
+}
+
+void ThreadPool::wait(TaskGroup& group) {
+    unsigned self = currentPool == this ? currentQueue : queues.size() - 1;
+
+    while(group.pending > 0) {
+        if(runOne(self))
+            continue;
+
+        std::unique_lock<std::mutex> lock(stateLock);
+        changed.wait(lock, [this, &group]() { return group.pending == 0 || queued > 0; });
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef THREAD_POOL_COMP
+#define THREAD_POOL_COMP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work stealing pool. Each thread has a queue of its own: it takes the newest task from its back and, when it is
+// empty, steals the oldest one from the front of another queue. Tasks submitted by a task go to the queue of the
+// thread running it, the ones from outside are spread over all the queues.
+// A pool of n threads starts n - 1 of them, the thread calling wait() is the last one. Tasks must not throw
+class ThreadPool {
+    public:
+        // Tasks submitted together, so whoever submitted them can wait for just those
+        struct TaskGroup {
+            std::atomic<size_t> pending{0};
+        };
+
+        explicit ThreadPool(unsigned threads);
+        ~ThreadPool();  // Waits for the tasks still queued
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(std::function<void()> task);
+        void submit(std::function<void()> task, TaskGroup& group);
+
+        // Runs tasks on the calling thread until every task submitted so far has finished. Not for the tasks themselves,
+        // the one calling it would never finish
+        void wait();
+
+        // Runs tasks on the calling thread until the tasks of group have finished. Unlike wait(), a task can call it for
+        // the tasks it submitted: the thread keeps working on whatever is queued in the meantime, even other groups
+        void wait(TaskGroup& group);
+
+        unsigned size() const { return queues.size(); }
+
+    private:
+        struct Queue {
+            std::mutex lock;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        bool runOne(unsigned self);     // Own task or a stolen one, false when every queue is empty
+        void work(unsigned self);
+
+        std::vector<std::unique_ptr<Queue>> queues;     // The last one belongs to the threads calling wait()
+        std::vector<std::thread> workers;
+
+        std::mutex stateLock;
+        std::condition_variable changed;    // A task was submitted, the last one finished or the pool is stopping
+        std::atomic<size_t> queued{0};      // In the queues
+        std::atomic<size_t> pending{0};     // Submitted and not finished
+        std::atomic<unsigned> nextQueue{0};
+        bool stopping = false;
+};
+
+#endif /* THREAD_POOL_COMP */
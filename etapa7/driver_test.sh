@@ -0,0 +1,74 @@
+#!/bin/bash
+
+# Testa o modo -j (driver/compile.cpp): compila varios arquivos de uma vez com -j 4 e compara cada .s com o da
+# compilacao serial, confere que entradas repetidas ou que sao o .s de outra entrada sao recusadas e que o
+# codigo de saida e o pior dos arquivos
+status=0
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+fail() {
+    echo "$1"
+    status=1
+}
+
+# O driver escreve arq.s ao lado de cada entrada, entao elas sao copiadas para o diretorio temporario
+inputs=()
+for expected in tests/*.out; do
+    f=$(basename "${expected%.out}")
+    cp "tests/$f" "$dir/$f"
+    inputs+=("$dir/$f")
+done
+
+cat > "$dir/semantic_error" << 'EOF'
+int main() {
+    undeclared = 1;
+}
+EOF
+
+cat > "$dir/syntax_error" << 'EOF'
+int main() {
+    print 1 +;
+}
+EOF
+
+for level in -O0 -O2; do
+    for f in "${inputs[@]}"; do
+        ./etapa7 $level "$f" "$f.serial.s" > /dev/null 2>&1 || fail "nao compila em serie: $f $level"
+    done
+
+    for f in "${inputs[@]}"; do
+        rm -f "$f.s"
+    done
+
+    ./etapa7 -j 4 $level "${inputs[@]}" > /dev/null 2>&1 || fail "-j 4 falhou: $level"
+
+    for f in "${inputs[@]}"; do
+        cmp -s "$f.s" "$f.serial.s" || fail "-j 4 diferente do serial: $f $level"
+    done
+done
+
+# Recusadas antes de compilar qualquer coisa
+a=${inputs[0]}
+b=${inputs[1]}
+rm -f "$a.s" "$b.s"
+
+./etapa7 -j 4 "$a" "$b" "$a" > /dev/null 2>&1
+[ $? -eq 1 ] || fail "entrada repetida nao foi recusada"
+
+./etapa7 -j 4 "$a" "$b" "$b.s" > /dev/null 2>&1
+[ $? -eq 1 ] || fail "entrada que e o .s de outra nao foi recusada"
+
+[ -e "$a.s" ] || [ -e "$b.s" ] && fail "entradas recusadas foram compiladas"
+
+# O codigo de saida e o pior dos arquivos, e os outros sao compilados mesmo assim
+./etapa7 -j 4 "$a" "$dir/syntax_error" "$b" > /dev/null 2>&1
+[ $? -eq 3 ] || fail "erro de sintaxe nao deu codigo 3"
+
+rm -f "$a.s" "$b.s"
+./etapa7 -j 4 "$a" "$dir/semantic_error" "$dir/syntax_error" "$b" > /dev/null 2>&1
+[ $? -eq 4 ] || fail "erro semantico nao deu codigo 4"
+
+[ -e "$a.s" ] && [ -e "$b.s" ] || fail "arquivos sem erro nao foram compilados"
+
+exit $status
@@ -0,0 +1,58 @@
+#include "mapped_file.h"
+
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool MappedFile::open(const std::string& path, size_t padding) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat info;
+    if(fstat(fd, &info) < 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t page = sysconf(_SC_PAGESIZE);
+    length = info.st_size;
+    mapped = (length + std::max<size_t>(padding, 2) + page - 1) & ~(page - 1);
+
+    // Anonymous zero pages first, then the file over the start of them. The bytes after the end of the file are
+    // zero either way: in the last page of the file the kernel clears them, and past it the anonymous pages remain
+    void* region = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(region == MAP_FAILED) {
+        ::close(fd);
+        mapped = length = 0;
+        return false;
+    }
+
+    if(length > 0 && mmap(region, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(region, mapped);
+        ::close(fd);
+        mapped = length = 0;
+        return false;
+    }
+
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+
+    base = static_cast<char*>(region);
+    madvise(base, mapped, MADV_SEQUENTIAL);
+
+    return true;
+}
+
+void MappedFile::close() {
+    if(base)
+        munmap(base, mapped);
+
+    base = nullptr;
+    length = mapped = 0;
+}
@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_COMP
+#define MAPPED_FILE_COMP
+
+#include <cstddef>
+#include <string>
+
+// Source file mapped in memory and followed by zero bytes, at least the two NULs that flex's yy_scan_buffer wants
+// at the end, so the scanner works on the file's pages instead of copying it through yyin.
+// The mapping is private and writable: flex writes a NUL after each token while it is in yytext
+class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // padding zero bytes come after the file, at least 2.
+        // false when the file can't be mapped (pipes, devices, ...), reading it with stdio still works then
+        bool open(const std::string& path, size_t padding = 2);
+        void close();
+
+        char* data() const { return base; }
+        size_t size() const { return length; }             // Without the padding
+        size_t bufferSize() const { return length + 2; }   // What yy_scan_buffer gets
+
+    private:
+        char* base = nullptr;
+        size_t length = 0;
+        size_t mapped = 0;
+};
+
+#endif /* MAPPED_FILE_COMP */
@@ -0,0 +1,12 @@
+#!/bin/bash
+
+# Compara os tokens do flex com os do lexer escrito a mao em todos os testes
+status=0
+for f in tests/*; do
+    case $f in *.s|*.out|*.in) continue;; esac
+    if ! diff <(./etapa7 --dump-tokens "$f") <(./etapa7 --dump-tokens --lexer=hand "$f") > /dev/null; then
+        echo "tokens diferentes: $f"
+        status=1
+    fi
+done
+exit $status
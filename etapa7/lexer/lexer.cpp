@@ -0,0 +1,328 @@
+#include "lexer.h"
+#include "../context/context.h"
+#include "../parser.tab.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// From scanner.l, the scanner is a yyscan_t
+int flexLex(YYSTYPE* lval, void* scanner);
+char* yyget_text(void* scanner);
+
+void useHandLexer(CompilationContext& ctx, const char* base, size_t size) {
+    ctx.handLexer.active = true;
+    ctx.handLexer.cursor = base;
+    ctx.handLexer.end = base + size;
+    ctx.handLexer.tokenStart = base;
+    ctx.handLexer.tokenLength = 0;
+}
+
+std::string_view tokenText(const CompilationContext& ctx) {
+    if(!ctx.handLexer.active) {
+        char* text = ctx.scanner ? yyget_text(ctx.scanner) : nullptr;
+        return text ? std::string_view(text) : std::string_view();
+    }
+
+    return std::string_view(ctx.handLexer.tokenStart, ctx.handLexer.tokenLength);
+}
+
+// ---------------------------------------------------------------------------------
+// Character classes, the same as the rules of scanner.l
+// ---------------------------------------------------------------------------------
+
+static bool isIdentifierStart(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '-';
+}
+
+static bool isIdentifierChar(unsigned char c) {
+    return isIdentifierStart(c) || (c >= '0' && c <= '9');
+}
+
+static bool isDigit(unsigned char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool isSingleCharToken(unsigned char c) {
+    return c != 0 && std::strchr("-,;:()[]{}=+*/%<>&|~", c) != nullptr;
+}
+
+// ---------------------------------------------------------------------------------
+// Runs of bytes, 32 (AVX2) or 16 (SSE2) at a time, with the loops of lexer_skip.inc. The Makefile builds for any
+// x86-64, so the AVX2 loops are compiled for it with the target attribute and used only when the processor has it
+// ---------------------------------------------------------------------------------
+
+// The loops of one instruction set, handLex is instantiated with each
+struct SkipLoops {
+    const char* (*whitespace)(const char* p, int& lines);
+    const char* (*identifier)(const char* p);
+    const char* (*lineComment)(const char* p);
+    const char* (*blockComment)(const char* p, int& lines);
+};
+
+#if defined(__SSE2__)
+namespace sse2 {
+
+#define LEXER_TARGET
+typedef __m128i Chunk;
+static const int ChunkSize = 16;
+static Chunk load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+static Chunk splat(char c) { return _mm_set1_epi8(c); }
+static Chunk eq(Chunk a, Chunk b) { return _mm_cmpeq_epi8(a, b); }
+static Chunk gt(Chunk a, Chunk b) { return _mm_cmpgt_epi8(a, b); }
+static Chunk both(Chunk a, Chunk b) { return _mm_and_si128(a, b); }
+static Chunk either(Chunk a, Chunk b) { return _mm_or_si128(a, b); }
+static uint32_t mask(Chunk a) { return static_cast<uint32_t>(_mm_movemask_epi8(a)); }
+
+#include "lexer_skip.inc"
+#undef LEXER_TARGET
+
+}
+
+namespace avx2 {
+
+#define LEXER_TARGET __attribute__((target("avx2")))
+typedef __m256i Chunk;
+static const int ChunkSize = 32;
+LEXER_TARGET static Chunk load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+LEXER_TARGET static Chunk splat(char c) { return _mm256_set1_epi8(c); }
+LEXER_TARGET static Chunk eq(Chunk a, Chunk b) { return _mm256_cmpeq_epi8(a, b); }
+LEXER_TARGET static Chunk gt(Chunk a, Chunk b) { return _mm256_cmpgt_epi8(a, b); }
+LEXER_TARGET static Chunk both(Chunk a, Chunk b) { return _mm256_and_si256(a, b); }
+LEXER_TARGET static Chunk either(Chunk a, Chunk b) { return _mm256_or_si256(a, b); }
+LEXER_TARGET static uint32_t mask(Chunk a) { return static_cast<uint32_t>(_mm256_movemask_epi8(a)); }
+
+#include "lexer_skip.inc"
+#undef LEXER_TARGET
+
+}
+
+static constexpr SkipLoops sse2Loops = {sse2::skipWhitespace, sse2::skipIdentifier, sse2::skipLineComment, sse2::skipBlockComment};
+static constexpr SkipLoops avx2Loops = {avx2::skipWhitespace, avx2::skipIdentifier, avx2::skipLineComment, avx2::skipBlockComment};
+#else
+namespace scalar {
+
+static const char* skipWhitespace(const char* p, int& lines) {
+    for(; *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'; p++)
+        lines += *p == '\n';
+
+    return p;
+}
+
+static const char* skipIdentifier(const char* p) {
+    while(isIdentifierChar(*p))
+        p++;
+
+    return p;
+}
+
+static const char* skipLineComment(const char* p) {
+    while(*p != '\n' && *p != '\0')
+        p++;
+
+    return p;
+}
+
+static const char* skipBlockComment(const char* p, int& lines) {
+    for(; *p != '\0'; p++) {
+        if(p[0] == '*' && p[1] == '/')
+            return p + 2;
+
+        lines += *p == '\n';
+    }
+
+    return p;
+}
+
+}
+
+static constexpr SkipLoops scalarLoops = {scalar::skipWhitespace, scalar::skipIdentifier, scalar::skipLineComment, scalar::skipBlockComment};
+#endif
+
+// ---------------------------------------------------------------------------------
+// Keywords, with a perfect hash of the first and last characters and the length
+// ---------------------------------------------------------------------------------
+
+struct Keyword {
+    const char* text;
+    int token;
+};
+
+static unsigned keywordHash(const char* p, size_t length) {
+    return (static_cast<unsigned char>(p[0]) ^ (static_cast<unsigned char>(p[length - 1]) << 3) ^ length) & 31;
+}
+
+struct KeywordTable {
+    Keyword slots[32] = {};
+
+    KeywordTable() {
+        static const Keyword keywords[] = {
+            {"char", KW_CHAR}, {"int", KW_INT}, {"float", KW_FLOAT}, {"bool", KW_BOOL},
+            {"if", KW_IF}, {"else", KW_ELSE}, {"while", KW_WHILE}, {"read", KW_READ},
+            {"print", KW_PRINT}, {"return", KW_RETURN}, {"true", LIT_TRUE}, {"false", LIT_FLASE},
+        };
+
+        for(const Keyword& k : keywords)
+            slots[keywordHash(k.text, std::strlen(k.text))] = k;
+    }
+};
+
+static const Keyword* findKeyword(const char* p, size_t length) {
+    // Built by the first call, the units scanned by other threads wait for it
+    static const KeywordTable table;
+
+    if(length < 2 || length > 6)
+        return nullptr;
+
+    const Keyword& k = table.slots[keywordHash(p, length)];
+    if(k.text && std::strlen(k.text) == length && std::memcmp(k.text, p, length) == 0)
+        return &k;
+
+    return nullptr;
+}
+
+// ---------------------------------------------------------------------------------
+
+static int token(HandLexerState& lexer, const char* start, const char* end, int type) {
+    lexer.tokenStart = start;
+    lexer.tokenLength = end - start;
+    lexer.cursor = end;
+    return type;
+}
+
+static int literal(HandLexerState& lexer, YYSTYPE* lval, const char* start, const char* end, int type, SymbolType symType) {
+    lval->symbol = insertSymbolIntoTable(std::string_view(start, end - start), symType);
+    return token(lexer, start, end, type);
+}
+
+// Longest match like flex, and the first rule of scanner.l when two matches have the same length
+template<const SkipLoops& loops>
+static int handLex(YYSTYPE* lval, CompilationContext& ctx) {
+    HandLexerState& lexer = ctx.handLexer;
+    int& lineNumber = ctx.lineNumber;
+    const char* sourceEnd = lexer.end;
+    const char* p = lexer.cursor;
+
+    // The comment loops stop at zero bytes, the ones before the end of the source are part of the comment
+    while(true) {
+        p = loops.whitespace(p, lineNumber);
+
+        if(p[0] == '/' && p[1] == '/') {
+            p = loops.lineComment(p + 2);
+            while(*p == '\0' && p < sourceEnd)
+                p = loops.lineComment(p + 1);
+            continue;
+        }
+
+        if(p[0] == '/' && p[1] == '*') {
+            p = loops.blockComment(p + 2, lineNumber);
+            while(*p == '\0' && p < sourceEnd)
+                p = loops.blockComment(p + 1, lineNumber);
+            continue;
+        }
+
+        break;
+    }
+
+    const char* start = p;
+    unsigned char c = *p;
+
+    if(p >= sourceEnd) {
+        ctx.running = false;
+        return token(lexer, sourceEnd, sourceEnd, 0);
+    }
+
+    // A lone - is the operator, followed by an identifier character it starts an identifier
+    if(isIdentifierStart(c) && (c != '-' || isIdentifierChar(p[1]))) {
+        const char* end = loops.identifier(p + 1);
+
+        if(const Keyword* k = findKeyword(start, end - start)) {
+            if(k->token == LIT_TRUE || k->token == LIT_FLASE)
+                return literal(lexer, lval, start, end, k->token, SymbolType::Bool);
+
+            return token(lexer, start, end, k->token);
+        }
+
+        return literal(lexer, lval, start, end, TK_IDENTIFIER, SymbolType::Identifier);
+    }
+
+    if(isDigit(c)) {
+        const char* end = p + 1;
+        while(isDigit(*end))
+            end++;
+
+        if(end[0] == '.' && isDigit(end[1])) {
+            end += 2;
+            while(isDigit(*end))
+                end++;
+
+            return literal(lexer, lval, start, end, LIT_FLOAT, SymbolType::Float);
+        }
+
+        return literal(lexer, lval, start, end, LIT_INT, SymbolType::Integer);
+    }
+
+    if(c == '\'') {
+        // '\x' is longer than '\' so it wins when both match
+        if(p[1] == '\\' && p[2] != '\n' && p + 2 < sourceEnd && p[3] == '\'')
+            return literal(lexer, lval, start, p + 4, LIT_CHAR, SymbolType::Char);
+
+        if(p[1] != '\n' && p + 1 < sourceEnd && p[2] == '\'')
+            return literal(lexer, lval, start, p + 3, LIT_CHAR, SymbolType::Char);
+
+        return token(lexer, start, p + 1, TOKEN_ERROR);
+    }
+
+    if(c == '"') {
+        const char* end = p + 1;
+
+        while(end < sourceEnd && *end != '"' && *end != '\n') {
+            if(*end == '\\') {
+                if(end + 1 >= sourceEnd || end[1] == '\n')
+                    break;
+                end++;
+            }
+            end++;
+        }
+
+        if(end < sourceEnd && *end == '"')
+            return literal(lexer, lval, start, end + 1, LIT_STRING, SymbolType::String);
+
+        return token(lexer, start, p + 1, TOKEN_ERROR);
+    }
+
+    if(p[1] == '=') {
+        switch(c) {
+            case '<': return token(lexer, start, p + 2, OPERATOR_LE);
+            case '>': return token(lexer, start, p + 2, OPERATOR_GE);
+            case '=': return token(lexer, start, p + 2, OPERATOR_EQ);
+            case '!': return token(lexer, start, p + 2, OPERATOR_DIF);
+            default: break;
+        }
+    }
+
+    if(isSingleCharToken(c))
+        return token(lexer, start, p + 1, c);
+
+    return token(lexer, start, p + 1, TOKEN_ERROR);
+}
+
+typedef int (*HandLexer)(YYSTYPE* lval, CompilationContext& ctx);
+
+// The AVX2 loops when the processor has them, chosen once before main
+static HandLexer pickHandLexer() {
+#if defined(__SSE2__)
+    __builtin_cpu_init();   // The constructor of libgcc that fills what __builtin_cpu_supports reads may not have run yet
+    return __builtin_cpu_supports("avx2") ? handLex<avx2Loops> : handLex<sse2Loops>;
+#else
+    return handLex<scalarLoops>;
+#endif
+}
+
+static const HandLexer handLexer = pickHandLexer();
+
+int yylex(YYSTYPE* lval, CompilationContext& ctx) {
+    return ctx.handLexer.active ? handLexer(lval, ctx) : flexLex(lval, ctx.scanner);
+}
@@ -0,0 +1,30 @@
+#ifndef LEXER_COMP
+#define LEXER_COMP
+
+#include <cstddef>
+#include <cstdio>
+#include <string_view>
+
+union YYSTYPE;
+class CompilationContext;
+
+// Zero bytes the hand written lexer needs after the end of the source, its loops read 32 bytes at a time
+const size_t LexerPadding = 64;
+
+// The flex scanner of the unit (scanner.l), reading in or in place from the size bytes at base, which must be
+// followed by two zero bytes (MappedFile). The context stops it when it is destroyed
+void startScanner(CompilationContext& ctx, FILE* in);
+void scanInPlace(CompilationContext& ctx, char* base, size_t size);
+void stopScanner(CompilationContext& ctx);
+
+// The unit scans base[0, size) with the hand written lexer instead of flex, the LexerPadding bytes after it must be zero.
+// Both give the same tokens, semantic values and line numbers
+void useHandLexer(CompilationContext& ctx, const char* base, size_t size);
+
+// Dispatches to flex or to the hand written lexer, the pure parser calls it
+int yylex(YYSTYPE* lval, CompilationContext& ctx);
+
+// Text of the last token of the unit, for the error messages
+std::string_view tokenText(const CompilationContext& ctx);
+
+#endif /* LEXER_COMP */
@@ -6,77 +6,74 @@
 #include <errno.h>
 #include <stdlib.h>
 
-#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
 
-#include "./tacs/tacs.h"
-#include "./semantic_check/semantic_check.h"
-#include "./asm/asm.h"
+#include "./passes/passes.h"
+#include "./driver/compile.h"
 
-int yylex(void);
-int yyparse(void);
-
-extern FILE *yyin;
-extern char *yytext;
-extern int yydebug;
-extern ASTNode* root;
-extern int syntax_error_count;
-
-int isRunning(void);
-void initMe(void);
-int getLineNumber(void);
+static void usage() {
+    fprintf(stderr, "Call: ./a.out file_name [output_file] [--dump-cfg[=file.dot]] [-O0|-O1|-O2|-O3|-Os] "
+                    "[--disable-pass=name[,name...]] [--time-passes] [--no-mmap] [--lexer=flex|hand] [--dump-tokens]\n"
+                    "      ./a.out -j N file_name [file_name...] [options], each file into file_name.s, N = 0 uses every core\n"
+                    "      -O3 is -O2 with twice the rounds of the SSA passes\n");
+    exit(1);
+}
 
 int main(int argc, char **argv) {
     // int tok;
-    if(argc < 2) {
-        fprintf(stderr, "Call: ./a.out file_name\n");
-        exit(1);
-    }
-
-    if((yyin = fopen(argv[1],"r")) == 0) {
-        fprintf(stderr, "Didn't find the filename %s\n", argv[1]);
-        exit(2);
-    }
-
-    // yydebug = 1;
-    while(isRunning()) {
-        yyparse();
-    }
-
-    // root->print();
-
-    if(ASTSemErrorCheck(root)) {
-        std::cout << "\nExit 4\n";
-        exit(4);
+    std::vector<std::string> files;
+    CompileOptions options;
+    bool driver = false;
+    unsigned threads = 0;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if(arg == "--no-mmap") {
+            options.mapInput = false;
+        } else if(arg == "--lexer=hand" || arg == "--lexer=flex") {
+            options.handLexer = arg == "--lexer=hand";
+        } else if(arg == "--dump-tokens") {
+            options.dumpTokens = true;
+        } else if(arg == "--dump-cfg") {
+            options.dumpCfg = true;
+        } else if(arg.rfind("--dump-cfg=", 0) == 0) {
+            options.dumpCfg = true;
+            options.cfgFilename = arg.substr(std::string("--dump-cfg=").size());
+        } else if(arg.rfind("-j", 0) == 0) {
+            // -j N or -jN
+            std::string count = arg.size() > 2 ? arg.substr(2) : (i + 1 < argc ? argv[++i] : "");
+            if(count.empty() || count.find_first_not_of("0123456789") != std::string::npos)
+                usage();
+
+            driver = true;
+            threads = std::stoul(count);
+        } else {
+            try {
+                if(!parsePassOption(options.passes, arg))
+                    files.push_back(arg);
+            } catch(const std::invalid_argument& e) {
+                fprintf(stderr, "%s\n", e.what());
+                exit(1);
+            }
+        }
     }
 
-   if(syntax_error_count > 0) {
-        fprintf(stderr, "Compilation failed with %d syntax errors.\n", syntax_error_count);
-        exit(3);
-    }
+    if(files.size() < 1)
+        usage();
 
-    // printSymbolsTable();
-    // std::cout << "\n\n";
-    // tacPrintList(generateCode(root));
+    // Every input has its own .s and .dot in the driver
+    if(driver) {
+        if(!options.cfgFilename.empty()) {
+            fprintf(stderr, "--dump-cfg=file takes a single input, with -j each one goes to file_name.dot\n");
+            exit(1);
+        }
 
-    std::string output_filename;
-    if (argc >= 3) {
-        output_filename = argv[2];
-    } else {
-        output_filename = std::string(argv[1]) + ".s";
+        exit(compileFiles(options, files, threads));
     }
 
-    std::ofstream out(output_filename);
-    if (!out.is_open()) {
-        std::cerr << "Error: Could not open output file " << output_filename << std::endl;
-        return 1;
-    }
-
-    out << generateAsm(generateCode(root));
-    out.close();
-
-    // std::cout << "\n\nASM:\n\n" << generateAsm(generateCode(root));
-
-    fclose(yyin);
-    exit(0);
-}
\ No newline at end of file
+    exit(compileFile(options, files[0], files.size() >= 2 ? files[1] : "", std::cout, std::cerr));
+}
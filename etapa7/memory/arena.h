@@ -0,0 +1,100 @@
+#ifndef ARENA_COMP
+#define ARENA_COMP
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+// Bump-pointer allocator for objects of a single type, used through the operator new/delete of the class.
+// Memory comes in chunks of many objects, deleted objects go to a free list that the next allocation reuses,
+// and release() destroys whatever is still alive and gives all the chunks back at once. Each slot knows the arena
+// that allocated it, only that one takes it back
+template<typename T>
+class Arena {
+    public:
+        explicit Arena(size_t objectsPerChunk = 1024) : perChunk(objectsPerChunk) {}
+        ~Arena() { release(); }
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        void* allocate() {
+            Slot* slot = freeList;
+
+            if(slot) {
+                std::memcpy(&freeList, slot->storage, sizeof(Slot*));
+            } else {
+                if(chunks.empty() || used == perChunk) {
+                    chunks.push_back(static_cast<Slot*>(::operator new(sizeof(Slot) * perChunk)));
+                    used = 0;
+                }
+
+                slot = &chunks.back()[used++];
+            }
+
+            slot->owner = this;
+            return slot->storage;
+        }
+
+        // The object was already destroyed by the delete expression and must have been allocated by this arena
+        void deallocate(void* p) {
+            if(!p)
+                return;
+
+            Slot* slot = reinterpret_cast<Slot*>(p);
+            if(slot->owner != this) {
+                fprintf(stderr, "Arena: object freed by an arena that didn't allocate it\n");
+                abort();
+            }
+
+            slot->owner = nullptr;
+            std::memcpy(slot->storage, &freeList, sizeof(Slot*));
+            freeList = slot;
+        }
+
+        // Frees an object of an arena that other threads may be using, without touching that arena: the slot is
+        // only marked free, so its release() doesn't destroy the object again, and it isn't reused
+        static void abandon(void* p) {
+            if(p)
+                reinterpret_cast<Slot*>(p)->owner = nullptr;
+        }
+
+        // The arena that allocated p, which must be alive
+        static Arena* ownerOf(const void* p) { return reinterpret_cast<const Slot*>(p)->owner; }
+
+        void release() {
+            for(size_t c = 0; c < chunks.size(); c++) {
+                size_t count = c + 1 == chunks.size() ? used : perChunk;
+
+                for(size_t i = 0; i < count; i++)
+                    if(chunks[c][i].owner)
+                        reinterpret_cast<T*>(chunks[c][i].storage)->~T();
+
+                ::operator delete(chunks[c]);
+            }
+
+            chunks.clear();
+            freeList = nullptr;
+            used = 0;
+        }
+
+        size_t capacity() const { return chunks.size() * perChunk; }
+
+    private:
+        // storage comes first, so a T* is also a Slot*. While the slot is free it holds the next free slot and
+        // owner is null
+        struct Slot {
+            alignas(T) unsigned char storage[sizeof(T) < sizeof(void*) ? sizeof(void*) : sizeof(T)];
+            Arena* owner;
+        };
+
+        size_t perChunk;
+        std::vector<Slot*> chunks;
+        size_t used = 0;            // Slots handed out from the last chunk
+        Slot* freeList = nullptr;
+};
+
+#endif /* ARENA_COMP */
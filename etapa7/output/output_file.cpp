@@ -0,0 +1,106 @@
+#include "output_file.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+bool OutputFile::open(const std::string& path) {
+    close();
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+        return false;
+
+    failed = false;
+    buffer.resize(BufferSize);
+    setp(buffer.data(), buffer.data() + buffer.size());
+
+    return true;
+}
+
+bool OutputFile::close() {
+    if(fd < 0)
+        return true;
+
+    drain();
+
+    if(::close(fd) < 0)
+        failed = true;
+
+    fd = -1;
+    setp(nullptr, nullptr);
+
+    return !failed;
+}
+
+// write may take only part of the data, or be interrupted by a signal
+bool OutputFile::writeAll(const char* data, size_t size) {
+    while(size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if(written < 0) {
+            if(errno == EINTR)
+                continue;
+
+            failed = true;
+            return false;
+        }
+
+        data += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+// The bytes in the buffer go to the file, and the buffer is empty again even when the write failed
+bool OutputFile::drain() {
+    bool ok = writeAll(pbase(), pptr() - pbase());
+    setp(buffer.data(), buffer.data() + buffer.size());
+
+    return ok;
+}
+
+OutputFile::int_type OutputFile::overflow(int_type ch) {
+    if(fd < 0 || !drain())
+        return traits_type::eof();
+
+    if(!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize OutputFile::xsputn(const char* s, std::streamsize n) {
+    if(fd < 0)
+        return 0;
+
+    size_t size = n;
+
+    if(size <= size_t(epptr() - pptr())) {
+        std::memcpy(pptr(), s, size);
+        pbump(size);
+        return n;
+    }
+
+    if(!drain())
+        return 0;
+
+    if(size >= buffer.size())
+        return writeAll(s, size) ? n : 0;
+
+    std::memcpy(pptr(), s, size);
+    pbump(size);
+
+    return n;
+}
+
+int OutputFile::sync() {
+    if(fd < 0)
+        return 0;
+
+    return drain() ? 0 : -1;
+}
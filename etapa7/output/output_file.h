@@ -0,0 +1,42 @@
+#ifndef OUTPUT_FILE_COMP
+#define OUTPUT_FILE_COMP
+
+#include <cstddef>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// Output file written through a buffer of BufferSize bytes straight to its descriptor, with an std::ostream over it
+// (std::ostream out(&file)). The backend streams the assembly into it and flushes it after each function, so the
+// program is never in memory as a whole. Writes as big as the buffer skip it
+class OutputFile : public std::streambuf {
+    public:
+        static const size_t BufferSize = 64 * 1024;
+
+        OutputFile() = default;
+        ~OutputFile() { close(); }
+
+        OutputFile(const OutputFile&) = delete;
+        OutputFile& operator=(const OutputFile&) = delete;
+
+        // Creates or truncates path, false when it can't be opened for writing
+        bool open(const std::string& path);
+
+        // Writes what is left in the buffer. false when some write failed since open (disk full, ...)
+        bool close();
+
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char* s, std::streamsize n) override;
+        int sync() override;
+
+    private:
+        bool writeAll(const char* data, size_t size);
+        bool drain();
+
+        int fd = -1;
+        bool failed = false;
+        std::vector<char> buffer;
+};
+
+#endif /* OUTPUT_FILE_COMP */
@@ -0,0 +1,265 @@
+#include "passes.h"
+#include "../ssa/ssa.h"
+#include "../cfg/dataflow.h"
+#include "../context/context.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+static const std::vector<OptLevel> allLevels = {OptLevel::O0, OptLevel::O1, OptLevel::O2, OptLevel::O3, OptLevel::Os};
+static const std::vector<OptLevel> fromO1 = {OptLevel::O1, OptLevel::O2, OptLevel::O3, OptLevel::Os};
+static const std::vector<OptLevel> fromO2 = {OptLevel::O2, OptLevel::O3, OptLevel::Os};
+static const std::vector<OptLevel> speedOnly = {OptLevel::O1, OptLevel::O2, OptLevel::O3};   // They make the code bigger
+static const std::vector<OptLevel> fastOnly = {OptLevel::O2, OptLevel::O3};
+
+static std::vector<Pass>& passes() {
+    static std::vector<Pass> list = {
+        {"symbols", "removes the SYMBOL TACs", {}, allLevels, removeAllTacSymbols},
+        {"unreachable", "removes the code after a RET", {}, fromO1, removeDeadCode},
+        {"jumps", "removes jumps to the next TAC", {}, fromO1, removeRedundancy},
+        {"ssa", "SSA pipeline, runs the passes that depend on it", {}, fromO1, optimizeSSA, prepareSSA},
+        {"sccp", "sparse conditional constant propagation", {"ssa"}, fromO1, nullptr},
+        {"copyprop", "copy propagation", {"ssa"}, fromO1, nullptr},
+        {"gvn", "value numbering over the dominator tree", {"ssa"}, fromO2, nullptr},
+        {"licm", "loop invariant code motion", {"ssa"}, fromO2, nullptr},
+        {"ssa-dce", "removes the SSA names nobody reads", {"ssa"}, fromO1, nullptr},
+        {"dse", "removes dead stores with liveness", {}, fromO1, [](TACList& list) { removeDeadStores(list); }},
+        {"regalloc", "linear scan register allocation", {}, fromO1, nullptr},
+        {"fuse-branches", "compare and IFZ become a single cmp and jcc", {}, fromO1, nullptr},
+        {"div-by-const", "division by constants with a multiplication", {}, speedOnly, nullptr},
+        {"vector-bases", "vector addresses in registers inside loops", {}, fastOnly, nullptr},
+        {"align-loops", "aligns the loop headers", {}, fastOnly, nullptr},
+    };
+
+    return list;
+}
+
+// Order the list passes run in, a pass may show up more than once
+static const std::vector<std::string> pipeline = {"symbols", "unreachable", "jumps", "ssa", "dse", "jumps"};
+
+static Pass* findPass(const std::string& name) {
+    for(Pass& pass : passes())
+        if(pass.name == name)
+            return &pass;
+
+    return nullptr;
+}
+
+void registerPass(const Pass& pass) {
+    if(findPass(pass.name))
+        throw std::invalid_argument("pass " + pass.name + " registered twice");
+
+    passes().push_back(pass);
+}
+
+const std::vector<Pass>& registeredPasses() {
+    return passes();
+}
+
+bool parsePassOption(PassOptions& options, const std::string& arg) {
+    static const std::map<std::string, OptLevel> levels = {
+        {"-O0", OptLevel::O0}, {"-O1", OptLevel::O1}, {"-O2", OptLevel::O2}, {"-O3", OptLevel::O3}, {"-Os", OptLevel::Os},
+    };
+
+    auto it = levels.find(arg);
+    if(it != levels.end()) {
+        options.level = it->second;
+        return true;
+    }
+
+    if(arg == "--time-passes") {
+        options.timing = true;
+        return true;
+    }
+
+    const std::string disable = "--disable-pass=";
+    if(arg.rfind(disable, 0) != 0)
+        return false;
+
+    std::string names = arg.substr(disable.size());
+    size_t start = 0;
+
+    while(start <= names.size()) {
+        size_t end = std::min(names.find(',', start), names.size());
+        std::string name = names.substr(start, end - start);
+
+        if(!findPass(name))
+            throw std::invalid_argument("unknown pass '" + name + "'");
+
+        options.disabled.insert(name);
+        start = end + 1;
+    }
+
+    return true;
+}
+
+bool isPassEnabled(const PassOptions& options, const std::string& name) {
+    Pass* pass = findPass(name);
+    if(!pass || options.disabled.count(name))
+        return false;
+
+    if(std::find(pass->levels.begin(), pass->levels.end(), options.level) == pass->levels.end())
+        return false;
+
+    for(const std::string& dependency : pass->dependencies)
+        if(!isPassEnabled(options, dependency))
+            return false;
+
+    return true;
+}
+
+PassFlags resolvePassFlags(const PassOptions& options) {
+    PassFlags flags;
+    flags.sccp = isPassEnabled(options, "sccp");
+    flags.copyprop = isPassEnabled(options, "copyprop");
+    flags.gvn = isPassEnabled(options, "gvn");
+    flags.licm = isPassEnabled(options, "licm");
+    flags.ssaDce = isPassEnabled(options, "ssa-dce");
+    flags.regalloc = isPassEnabled(options, "regalloc");
+    flags.fuseBranches = isPassEnabled(options, "fuse-branches");
+    flags.divByConst = isPassEnabled(options, "div-by-const");
+    flags.vectorBases = isPassEnabled(options, "vector-bases");
+    flags.alignLoops = isPassEnabled(options, "align-loops");
+    flags.ssaRounds = options.level == OptLevel::O3 ? 8 : 4;
+    return flags;
+}
+
+// What the functions printed and timed and the symbols they made go back to the unit, in source order
+static void collectFunctions() {
+    CompilationContext& ctx = context();
+
+    nameGeneratedSymbols();
+
+    for(auto& function : ctx.functions) {
+        *ctx.out << function->out.str();
+        function->out.str("");
+
+        for(const std::string& name : function->timedOrder) {
+            const PassTime& time = function->passTimes[name];
+
+            if(!ctx.passTimes.count(name))
+                ctx.timedOrder.push_back(name);
+
+            PassTime& total = ctx.passTimes[name];
+            total.runs += time.runs;
+            total.ms += time.ms;
+            total.tacsBefore += time.tacsBefore;
+            total.tacsAfter += time.tacsAfter;
+        }
+
+        function->timedOrder.clear();
+        function->passTimes.clear();
+    }
+}
+
+void runPassPipeline(TACList& list) {
+    const PassOptions& options = context().options;
+    bool timing = options.timing;
+    std::vector<Pass*> stage;
+
+    // The functions go through the passes between two prepares without waiting for each other
+    auto runStage = [&stage, timing]() {
+        if(stage.empty())
+            return;
+
+        forEachFunction([&stage, timing](FunctionContext& function) {
+            for(Pass* pass : stage) {
+                PassTimer timer(pass->name, timing ? countTACs(function.code) : 0);
+                pass->run(function.code);
+                timer.stop(timing ? countTACs(function.code) : 0);
+            }
+        });
+
+        collectFunctions();
+        stage.clear();
+    };
+
+    splitFunctions(list);
+
+    for(const std::string& name : pipeline) {
+        if(!isPassEnabled(options, name))
+            continue;
+
+        Pass* pass = findPass(name);
+
+        if(pass->prepare) {
+            runStage();
+
+            TACList whole = joinFunctions();
+            pass->prepare(whole);
+            splitFunctions(whole);
+        }
+
+        stage.push_back(pass);
+    }
+
+    runStage();
+    list = joinFunctions();
+}
+
+PassTimer::PassTimer(const std::string& name, size_t tacsBefore)
+    : name(name), tacsBefore(tacsBefore), start(std::chrono::steady_clock::now()) {}
+
+void PassTimer::stop(size_t tacsAfter) {
+    if(!timePasses())
+        return;
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    CompilationContext& ctx = context();
+    FunctionContext* function = currentFunction();
+    std::vector<std::string>& timedOrder = function ? function->timedOrder : ctx.timedOrder;
+    std::map<std::string, PassTime>& passTimes = function ? function->passTimes : ctx.passTimes;
+
+    if(!passTimes.count(name))
+        timedOrder.push_back(name);
+
+    PassTime& time = passTimes[name];
+    time.runs++;
+    time.ms += elapsed.count();
+    time.tacsBefore += tacsBefore;
+    time.tacsAfter += tacsAfter;
+}
+
+bool timePasses() {
+    return context().options.timing;
+}
+
+size_t countTACs(const TACList& list) {
+    size_t count = 0;
+
+    for(TAC* t = list.head; t; t = t->next)
+        count++;
+
+    return count;
+}
+
+void printPassTimes(std::ostream& out) {
+    if(!timePasses())
+        return;
+
+    // The passes run once per function, so their TAC counts are the sums over the functions. So are the times,
+    // with the functions on many threads they add up to more than the time the unit took
+    out << "===== Pass execution times =====\n"
+        << std::left << std::setw(16) << "pass" << std::right << std::setw(6) << "runs" << std::setw(12) << "time (ms)"
+        << std::setw(14) << "TACs before" << std::setw(14) << "TACs after" << "\n";
+
+    CompilationContext& ctx = context();
+    double total = 0;
+
+    for(const std::string& name : ctx.timedOrder) {
+        const PassTime& time = ctx.passTimes[name];
+
+        // The passes that run inside another one are already in its time
+        if(findPass(name) && findPass(name)->run)
+            total += time.ms;
+
+        out << std::left << std::setw(16) << name << std::right << std::setw(6) << time.runs
+            << std::setw(12) << std::fixed << std::setprecision(3) << time.ms
+            << std::setw(14) << time.tacsBefore << std::setw(14) << time.tacsAfter << "\n";
+    }
+
+    out << std::left << std::setw(16) << "total" << std::right << std::setw(6) << "" << std::setw(12) << total << "\n";
+}
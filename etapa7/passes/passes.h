@@ -0,0 +1,93 @@
+#ifndef PASSES_COMP
+#define PASSES_COMP
+
+#include "../tacs/tacs.h"
+
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+enum class OptLevel { O0, O1, O2, O3, Os };
+
+struct Pass {
+    std::string name;
+    std::string description;
+    std::vector<std::string> dependencies;  // The pass is off whenever one of these is off
+    std::vector<OptLevel> levels;           // Levels where it is on
+    std::function<void(TACList&)> run;      // Empty for the passes run by another one (the SSA passes) and by the backend
+
+    // Part of the pass that needs the whole program, it runs on the whole list before run gets each function
+    std::function<void(const TACList&)> prepare;
+};
+
+void registerPass(const Pass& pass);
+const std::vector<Pass>& registeredPasses();
+
+// Pass options of one invocation. The driver gives them to every unit it compiles (CompilationContext::options),
+// nothing about them is global
+struct PassOptions {
+    OptLevel level = OptLevel::O2;
+    std::set<std::string> disabled;     // --disable-pass
+    bool timing = false;                // --time-passes
+};
+
+// Handles -O0, -O1, -O2, -O3, -Os, --disable-pass=a,b and --time-passes, into options.
+// Returns false when arg isn't one of them, throws std::invalid_argument for unknown passes
+bool parsePassOption(PassOptions& options, const std::string& arg);
+
+// Looks the pass up and checks the level, --disable-pass and its dependencies
+bool isPassEnabled(const PassOptions& options, const std::string& name);
+
+// The passes that are on, resolved with isPassEnabled once when a unit starts (CompilationContext::passes). The SSA
+// pipeline and the backend ask for each function and TAC, so they read these instead
+struct PassFlags {
+    bool sccp = false;
+    bool copyprop = false;
+    bool gvn = false;
+    bool licm = false;
+    bool ssaDce = false;
+    bool regalloc = false;
+    bool fuseBranches = false;
+    bool divByConst = false;
+    bool vectorBases = false;
+    bool alignLoops = false;
+    int ssaRounds = 4;      // Rounds of the SSA passes, the only thing -O3 adds to -O2 is 8 of them
+};
+
+PassFlags resolvePassFlags(const PassOptions& options);
+
+// Runs the enabled passes that work on the TAC list, in pipeline order. Each function goes through them on its own
+// (forEachFunction), so list is cut into the functions of the unit and put back together at the end
+void runPassPipeline(TACList& list);
+
+// With --time-passes, measures the pass from construction to stop() and adds it to the report
+class PassTimer {
+    public:
+        PassTimer(const std::string& name, size_t tacsBefore);
+        void stop(size_t tacsAfter);
+
+    private:
+        std::string name;
+        size_t tacsBefore;
+        std::chrono::steady_clock::time_point start;
+};
+
+// What --time-passes collected for one pass, kept in the CompilationContext of the unit
+struct PassTime {
+    int runs = 0;
+    double ms = 0;
+    size_t tacsBefore = 0;
+    size_t tacsAfter = 0;
+};
+
+// --time-passes of the current unit
+bool timePasses();
+size_t countTACs(const TACList& list);
+
+// Wall time, runs and TAC counts of every pass timed in the current unit, in the order they first ran
+void printPassTimes(std::ostream& out);
+
+#endif /* PASSES_COMP */
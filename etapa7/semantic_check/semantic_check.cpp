@@ -1,4 +1,5 @@
 #include "semantic_check.h"
+#include "../context/context.h"
 
 #include <iostream>
 #include <string>
@@ -17,13 +18,16 @@ static bool areCompatible(const DataType& a, const DataType& b) {
 }
 
 // Top-Down pass to check declarations and uses of symbols
-bool checkDeclarations(ASTNode* node) {
-    if(node == nullptr)
+bool checkDeclarations(ASTNodeId node) {
+    if(node == NoNode)
         return false;
 
+    AST& ast = context().ast;
+    std::ostream& out = *context().out;
     bool hasError = false;
+    Symbol* nodeSymbol = ast.symbol[node];
 
-    switch (node->type) {
+    switch (ast.type[node]) {
         case ASTNodeType::Unknown:
             hasError = true;
 
@@ -32,21 +36,21 @@ bool checkDeclarations(ASTNode* node) {
         // Na especificação não há nenhuma informação sobre escopos, logo parametros e variáveis são considerados a mesma coisa
         case ASTNodeType::DecVar:
         case ASTNodeType::Param: {
-            Symbol* symbol = getSymbolFromTable(node->symbol->content);
+            Symbol* symbol = getSymbolFromTable(nodeSymbol->content);
             if(symbol == nullptr) {
                 hasError = true;
                 break;
             }
 
             if(symbol->symType == SymbolType::Identifier) { // It has not been specified yet
-                if(node->parent->type == ASTNodeType::LocalVarDecList) {
+                if(ast.type[ast.parent[node]] == ASTNodeType::LocalVarDecList) {
                     symbol->symType = SymbolType::Local;
                     symbol->inStack = true;
                 } else
                     symbol->symType = SymbolType::VarId;
 
             } else { // Has already been declared
-                std::cout << "Symbol '" << symbol->content << "' already has been declared\n";
+                out << "Symbol '" << symbol->content << "' already has been declared\n";
                 hasError = true;
                 break;
             }
@@ -55,7 +59,7 @@ bool checkDeclarations(ASTNode* node) {
         }
 
         case ASTNodeType::DecVarArray: {
-            Symbol* symbol = getSymbolFromTable(node->symbol->content);
+            Symbol* symbol = getSymbolFromTable(nodeSymbol->content);
             if(symbol == nullptr) {
                 hasError = true;
                 break;
@@ -64,36 +68,28 @@ bool checkDeclarations(ASTNode* node) {
             if(symbol->symType == SymbolType::Identifier) { // It has not been specified yet
                 symbol->symType = SymbolType::VecId;
             } else { // Has already been declared
-                std::cout << "Symbol '" << symbol->content << "' already has been declared\n";
+                out << "Symbol '" << symbol->content << "' already has been declared\n";
                 hasError = true;
                 break;
             }
 
-            int arraySize = stoi(node->children[0]->symbol->content);
+            int arraySize = ast.symbol[ast.child(node, 0)]->intValue;
             int count = 0;
 
-            // Check initialization
-            if(node->children.size() > 1)   {
-                ASTNode* curNode = node->children[1];
-                while (curNode->children.size() > 0){
-                    count++;
-
-                    if(!areCompatible(node->symbol->dataType, curNode->children[0]->symbol->dataType)) {
-                        std::cout << "Not compatible initialization: " << node->symbol->content << ", element: " << curNode->children[0]->symbol->content << '\n';
-                        hasError = true;
-                        break;
-                    }
-                    
-                    if(curNode->children.size() > 1) {
-                        curNode = curNode->children[1];
-                    } else
-                        break;
+            // Check initialization, an empty VetInit means the vector has none
+            for(ASTNodeId element : ast.children(ast.child(node, 1))) {
+                count++;
+
+                if(!areCompatible(nodeSymbol->dataType, ast.symbol[element]->dataType)) {
+                    out << "Not compatible initialization: " << nodeSymbol->content << ", element: " << ast.symbol[element]->content << '\n';
+                    hasError = true;
+                    break;
                 }
             }
 
             if(count != 0 && count != arraySize) {
                 hasError = true;
-                std::cout << "Array incorrectly initialized\n";
+                out << "Array incorrectly initialized\n";
             }
             
             break;
@@ -103,13 +99,14 @@ bool checkDeclarations(ASTNode* node) {
         case ASTNodeType::Identifier:
         case ASTNodeType::ArrayElement: 
         case ASTNodeType::FuncCall: {
-            // Inherit type from symbol before checking the declaration just for compatibility with the cmds
-            if(node->symbol) {
-                if(node->symbol->dataType == DataType::None) {
-                    // std::cout << "Symbol '" << node->symbol->content << "' has no data type\n";
+            // Inherit type from symbol before checking the declaration just for compatibility with the cmds.
+            // The strings of print have no type
+            if(nodeSymbol && nodeSymbol->symType != SymbolType::String) {
+                if(nodeSymbol->dataType == DataType::None) {
+                    // out << "Symbol '" << nodeSymbol->content << "' has no data type\n";
                     hasError = true;
                 } else {
-                    node->inferedType = node->symbol->dataType;
+                    ast.inferedType[node] = nodeSymbol->dataType;
                 }
             } 
         }
@@ -117,14 +114,14 @@ bool checkDeclarations(ASTNode* node) {
         case ASTNodeType::CmdAssign:
         case ASTNodeType::CmdArrayElementAssign: 
         case ASTNodeType::CmdRead: {
-            if(node->symbol == nullptr) {
-                std::cout << "Symbol not found\n";
+            if(nodeSymbol == nullptr) {
+                out << "Symbol not found\n";
                 hasError = true;
                 break;
             }
 
-            if(node->symbol->symType == SymbolType::Identifier) {
-                std::cout << "Symbol '" << node->symbol->content << "' has not been declared\n";
+            if(nodeSymbol->symType == SymbolType::Identifier) {
+                out << "Symbol '" << nodeSymbol->content << "' has not been declared\n";
                 hasError = true;
             }
             
@@ -132,20 +129,21 @@ bool checkDeclarations(ASTNode* node) {
         }
 
         case ASTNodeType::VetInit: {
-            if(node->parent == nullptr || node->parent->inferedType == DataType::None) {
-                std::cout << "Vector initialization with incorrect Variable\n";
+            ASTNodeId parent = ast.parent[node];
+            if(parent == NoNode || ast.inferedType[parent] == DataType::None) {
+                out << "Vector initialization with incorrect Variable\n";
                 hasError = true;
                 break;
             }
 
-            node->inferedType = node->parent->inferedType;
+            ast.inferedType[node] = ast.inferedType[parent];
             // Type of the vector elements will be checked on checkTypes function
 
             break;
         }
     
         case ASTNodeType::DecFunc: {
-            Symbol* symbol = getSymbolFromTable(node->symbol->content);
+            Symbol* symbol = getSymbolFromTable(nodeSymbol->content);
             if(symbol == nullptr) {
                 hasError = true;
                 break;
@@ -154,17 +152,13 @@ bool checkDeclarations(ASTNode* node) {
             if(symbol->symType == SymbolType::Identifier) { // It has not been specified yet
                 symbol->symType = SymbolType::FuncId;
             } else { // Has already been declared
-                std::cout << "Symbol '" << symbol->content << "' already has been declared\n";
+                out << "Symbol '" << symbol->content << "' already has been declared\n";
                 hasError = true;
                 break;
             }
 
-            if(node->children[0]->type == ASTNodeType::ParamList) {
-                ASTNode* paramList = nullptr;
-                for(paramList = node->children[0]; paramList != nullptr; paramList = paramList->children[1]) {
-                    node->symbol->params.push_back(paramList->children[0]->symbol);
-                }
-            }
+            for(ASTNodeId param : ast.children(ast.child(node, 0)))
+                nodeSymbol->params.push_back(ast.symbol[param]);
 
             break;
         }
@@ -176,66 +170,70 @@ bool checkDeclarations(ASTNode* node) {
     if(hasError)
         return hasError;
 
-    for (size_t i = 0; i < node->children.size(); i++)
+    for (ASTNodeId child : ast.children(node))
     {
-        hasError |= checkDeclarations(node->children[i]);
+        hasError |= checkDeclarations(child);
     }
 
     return hasError;
 }
 
 // Bottom-Up pass to check types in expressions
-bool checkTypes(ASTNode* node) {
-    if(node == nullptr)
+bool checkTypes(ASTNodeId node) {
+    if(node == NoNode)
         return false;
 
+    AST& ast = context().ast;
+    std::ostream& out = *context().out;
     bool hasError = false;
+    ASTChildren children = ast.children(node);
 
-    for (size_t i = 0; i < node->children.size(); i++)
+    for (ASTNodeId child : children)
     {
-        hasError |= checkTypes(node->children[i]);
+        hasError |= checkTypes(child);
     }
 
     if(hasError)
         return hasError;
 
-    switch (node->type) {
+    Symbol* nodeSymbol = ast.symbol[node];
+
+    switch (ast.type[node]) {
         case ASTNodeType::DecVar: {
-            if(node->children.size() > 0)
-            hasError |= !areCompatible(node->symbol->dataType, node->children[0]->inferedType);
+            hasError |= !areCompatible(nodeSymbol->dataType, ast.inferedType[children[0]]);
 
-            node->symbol->value = node->children[0];
-            node->children[0]->symbol->value = node; // Used to check if the value is used for the dec or somewhere else
+            nodeSymbol->value = children[0];
+            ast.symbol[children[0]]->value = node; // Used to check if the value is used for the dec or somewhere else
 
             break;
         }
 
         case ASTNodeType::DecVarArray: {
-            if(node->children.size() > 1)
-                hasError |= !areCompatible(node->symbol->dataType, node->children[1]->inferedType);
+            if(!ast.children(children[1]).empty())
+                hasError |= !areCompatible(nodeSymbol->dataType, ast.inferedType[children[1]]);
 
-            node->symbol->value = node;
+            nodeSymbol->value = node;
 
             break;
         }
 
         case ASTNodeType::DecFunc: {
-            node->symbol->value = node;
+            nodeSymbol->value = node;
 
             break;
         }
 
         case ASTNodeType::Identifier: {
-            if(node->symbol->symType == SymbolType::Identifier) {
-                std::cout << "Symbol '" << node->symbol->content << "' has not been declared\n";
+            if(nodeSymbol->symType == SymbolType::Identifier) {
+                out << "Symbol '" << nodeSymbol->content << "' has not been declared\n";
                 hasError = true;
                 break;
-            } else if(node->symbol->symType == SymbolType::FuncId) {
-                std::cout << "Function symbol '" << node->symbol->content << "' used as variable\n";
+            } else if(nodeSymbol->symType == SymbolType::FuncId) {
+                out << "Function symbol '" << nodeSymbol->content << "' used as variable\n";
                 hasError = true;
                 break;
-            } else if(node->symbol->symType == SymbolType::VecId) {
-                std::cout << "Vector symbol '" << node->symbol->content << "' used as variable\n";
+            } else if(nodeSymbol->symType == SymbolType::VecId) {
+                out << "Vector symbol '" << nodeSymbol->content << "' used as variable\n";
                 hasError = true;
                 break;
             }
@@ -244,58 +242,52 @@ bool checkTypes(ASTNode* node) {
         }
 
         case ASTNodeType::VetInit: {
-            if(node->children.size() > 0) {
-                hasError |= !areCompatible(node->inferedType, node->children[0]->inferedType);
-            } else {
-                std::cout << "Empty vector initialization\n";
-                hasError = true;
-            }
+            for(ASTNodeId element : children)
+                hasError |= !areCompatible(ast.inferedType[node], ast.inferedType[element]);
 
             break;
         }
 
         case ASTNodeType::CmdAssign: {
-            if(node->symbol == nullptr || (node->symbol->symType != SymbolType::VarId && node->symbol->symType != SymbolType::Local)) {
-                std::cout << "Assignment to non-variable\n";
+            if(nodeSymbol == nullptr || (nodeSymbol->symType != SymbolType::VarId && nodeSymbol->symType != SymbolType::Local)) {
+                out << "Assignment to non-variable\n";
                 hasError = true;
                 break;
             }
 
-            if(!areCompatible(node->symbol->dataType, node->children[0]->inferedType)) {
+            if(!areCompatible(nodeSymbol->dataType, ast.inferedType[children[0]])) {
                 hasError = true;
-                std::cout << "Assignment of symbol '" << node->symbol->content << "' type not compatible\n";
+                out << "Assignment of symbol '" << nodeSymbol->content << "' type not compatible\n";
             }
 
             break;
         }
 
         case ASTNodeType::CmdArrayElementAssign:  {
-            if(node->symbol == nullptr || node->symbol->symType != SymbolType::VecId) {
-                std::cout << "Assignment to non-vector\n";
+            if(nodeSymbol == nullptr || nodeSymbol->symType != SymbolType::VecId) {
+                out << "Assignment to non-vector\n";
                 hasError = true;
                 break;
             }
 
-            if(node->children[0]->inferedType != DataType::Int) {
+            if(ast.inferedType[children[0]] != DataType::Int) {
                 hasError = true;
-                std::cout << "Array index is not integer type\n";
+                out << "Array index is not integer type\n";
             }
 
-            if(!areCompatible(node->symbol->dataType, node->children[1]->inferedType)) {
+            if(!areCompatible(nodeSymbol->dataType, ast.inferedType[children[1]])) {
                 hasError = true;
-                std::cout << "Assignment of symbol '" << node->symbol->content << "' type not compatible\n";
+                out << "Assignment of symbol '" << nodeSymbol->content << "' type not compatible\n";
             }
 
             break;
         }
 
         case ASTNodeType::CmdReturn: {
-            ASTNode* funcNode = nullptr;
-
-            for(funcNode = node->parent; funcNode != nullptr; funcNode = funcNode->parent) {
-                if(funcNode->type == ASTNodeType::DecFunc) {
-                    if(!areCompatible(funcNode->symbol->dataType, node->children[0]->inferedType)) {
-                        std::cout << "Return type not compatible with function type\n";
+            for(ASTNodeId funcNode = ast.parent[node]; funcNode != NoNode; funcNode = ast.parent[funcNode]) {
+                if(ast.type[funcNode] == ASTNodeType::DecFunc) {
+                    if(!areCompatible(ast.symbol[funcNode]->dataType, ast.inferedType[children[0]])) {
+                        out << "Return type not compatible with function type\n";
                         return true;
                     } else
                         return hasError;
@@ -303,7 +295,7 @@ bool checkTypes(ASTNode* node) {
             }
         
             hasError = true;
-            std::cout << "Return statement not inside a function\n";
+            out << "Return statement not inside a function\n";
             break;
         }
 
@@ -313,21 +305,21 @@ bool checkTypes(ASTNode* node) {
         case ASTNodeType::OpMul:
         case ASTNodeType::OpDiv:
         case ASTNodeType::OpMod: {
-            node->inferedType = node->children[0]->inferedType;
+            ast.inferedType[node] = ast.inferedType[children[0]];
 
-            if(node->inferedType == DataType::None) {
-                std::cout << "Expression with undefined type\n";
+            if(ast.inferedType[node] == DataType::None) {
+                out << "Expression with undefined type\n";
                 hasError = true;
                 break;
-            } else if(node->inferedType == DataType::Bool) {
-                std::cout << "Expression with boolean type in arithmetic operation\n";
+            } else if(ast.inferedType[node] == DataType::Bool) {
+                out << "Expression with boolean type in arithmetic operation\n";
                 hasError = true;
                 break;
             }
 
-            if(!areCompatible(node->inferedType, node->children[1]->inferedType)) {
+            if(!areCompatible(ast.inferedType[node], ast.inferedType[children[1]])) {
                 hasError = true;
-                std::cout << "Arithmetic operation with incompatible types\n";
+                out << "Arithmetic operation with incompatible types\n";
             }
 
             break;
@@ -340,53 +332,53 @@ bool checkTypes(ASTNode* node) {
         case ASTNodeType::OpGreaterEqual:
         case ASTNodeType::OpEqual:
         case ASTNodeType::OpNotEqual: {
-            if(node->children[0]->inferedType == DataType::None) {
-                std::cout << "Expression with undefined type\n";
+            if(ast.inferedType[children[0]] == DataType::None) {
+                out << "Expression with undefined type\n";
                 hasError = true;
                 break;
-            } else if(node->inferedType == DataType::Bool) {
-                std::cout << "Expression with boolean type in relational operation\n";
+            } else if(ast.inferedType[node] == DataType::Bool) {
+                out << "Expression with boolean type in relational operation\n";
                 hasError = true;
                 break;
             }
 
-            if(!areCompatible(node->children[0]->inferedType, node->children[1]->inferedType)) {
-                std::cout << "Relational operation with incompatible types\n";
+            if(!areCompatible(ast.inferedType[children[0]], ast.inferedType[children[1]])) {
+                out << "Relational operation with incompatible types\n";
             }
             
-            node->inferedType = DataType::Bool;
+            ast.inferedType[node] = DataType::Bool;
 
             break;
         }
         
         case ASTNodeType::OpOr:
         case ASTNodeType::OpAnd: {
-            if(node->children[0]->inferedType != DataType::Bool || node->children[1]->inferedType != DataType::Bool) {
-                std::cout << "Expression with non-boolean type in logical operation\n";
+            if(ast.inferedType[children[0]] != DataType::Bool || ast.inferedType[children[1]] != DataType::Bool) {
+                out << "Expression with non-boolean type in logical operation\n";
                 hasError = true;
                 break;
             }
             
-            node->inferedType = DataType::Bool;
+            ast.inferedType[node] = DataType::Bool;
 
             break;
         }
 
         case ASTNodeType::OpNot: {
-            if(node->children[0]->inferedType != DataType::Bool) {
-                std::cout << "Expression with non-boolean type in logical operation\n";
+            if(ast.inferedType[children[0]] != DataType::Bool) {
+                out << "Expression with non-boolean type in logical operation\n";
                 hasError = true;
                 break;
             }
             
-            node->inferedType = DataType::Bool;
+            ast.inferedType[node] = DataType::Bool;
 
             break;
         }
 
         case ASTNodeType::ArrayElement: {
-            if(!areCompatible(node->children[0]->inferedType, DataType::Int)) {
-                std::cout << "Array index is not integer type\n";
+            if(!areCompatible(ast.inferedType[children[0]], DataType::Int)) {
+                out << "Array index is not integer type\n";
                 hasError = true;
             }
 
@@ -394,36 +386,34 @@ bool checkTypes(ASTNode* node) {
         }
 
         case ASTNodeType::FuncCall: {
-            if(node->symbol == nullptr || node->symbol->symType != SymbolType::FuncId) {
-                std::cout << "Call to non-function " << (node->symbol ? node->symbol->content : "") << "\n";
+            if(nodeSymbol == nullptr || nodeSymbol->symType != SymbolType::FuncId) {
+                out << "Call to non-function " << (nodeSymbol ? nodeSymbol->content : "") << "\n";
                 hasError = true;
                 break;
             }
 
-            ASTNode* argList = nullptr;
             size_t paramCount = 0;
 
-            if(node->children.size() > 0)
-                for(argList = node->children[0]; argList != nullptr; argList = argList->children[1]) {
-                    if(paramCount >= node->symbol->params.size()) {
-                        std::cout << "Too many arguments in function call: " << node->symbol->content << '\n';
-                        return true;
-                    }
-
-                    if(!areCompatible(node->symbol->params[paramCount]->dataType, argList->children[0]->inferedType)) {
-                        std::cout << "Argument type not compatible in function call: " << node->symbol->content << '\n';
-                        return true;
-                    }
+            for(ASTNodeId arg : ast.children(children[0])) {
+                if(paramCount >= nodeSymbol->params.size()) {
+                    out << "Too many arguments in function call: " << nodeSymbol->content << '\n';
+                    return true;
+                }
 
-                    paramCount++;
+                if(!areCompatible(nodeSymbol->params[paramCount]->dataType, ast.inferedType[arg])) {
+                    out << "Argument type not compatible in function call: " << nodeSymbol->content << '\n';
+                    return true;
                 }
 
-            if(paramCount < node->symbol->params.size()) {
-                std::cout << "Too few arguments in function call: " << node->symbol->content << '\n';
+                paramCount++;
+            }
+
+            if(paramCount < nodeSymbol->params.size()) {
+                out << "Too few arguments in function call: " << nodeSymbol->content << '\n';
                 hasError = true;
             }
 
-            node->inferedType = node->symbol->dataType;
+            ast.inferedType[node] = nodeSymbol->dataType;
 
             break;
         }
@@ -431,8 +421,8 @@ bool checkTypes(ASTNode* node) {
         case ASTNodeType::CmdIf: 
         case ASTNodeType::CmdIfElse:
         case ASTNodeType::CmdWhile: {
-            if(node->children[0]->inferedType != DataType::Bool) {
-                std::cout << "Condition expression is not boolean type\n";
+            if(ast.inferedType[children[0]] != DataType::Bool) {
+                out << "Condition expression is not boolean type\n";
                 hasError = true;
             }
 
@@ -447,7 +437,7 @@ bool checkTypes(ASTNode* node) {
 }
 
 
-bool ASTSemErrorCheck(ASTNode* node) {
+bool ASTSemErrorCheck(ASTNodeId node) {
     bool hasError = false;
 
     hasError |= checkDeclarations(node);
@@ -456,4 +446,4 @@ bool ASTSemErrorCheck(ASTNode* node) {
         hasError |= checkTypes(node);
 
     return hasError;
-}
\ No newline at end of file
+}
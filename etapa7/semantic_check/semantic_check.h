@@ -10,6 +10,6 @@
 // Return type
 
 // Returns the if there is a semantic error contained on the AST tree
-bool ASTSemErrorCheck(ASTNode* node);
+bool ASTSemErrorCheck(ASTNodeId node);
 
 #endif /* SEM_CHEQ */
\ No newline at end of file
@@ -0,0 +1,584 @@
+#include "ssa.h"
+
+#include <algorithm>
+#include <functional>
+
+static bool isVariable(Symbol* sym) {
+    return sym && sym->isFunctionScoped();
+}
+
+static void insertPhi(SSAFunction* ssa, BasicBlock* b, Symbol* var) {
+    TAC* phi = new TAC(TACType::PHI, var);
+    phi->args.assign(b->preds.size(), nullptr);
+
+    std::vector<TAC*>& blockPhis = ssa->phis[b];
+    TAC* pos = blockPhis.empty() ? b->first : blockPhis.back();
+
+    if(pos->type == TACType::LABEL || pos->type == TACType::PHI) {
+        tacInsertAfter(*ssa->list, pos, phi);
+        if(b->last == pos)
+            b->last = phi;
+    } else {
+        tacInsertBefore(*ssa->list, pos, phi);
+        b->first = phi;
+    }
+
+    blockPhis.push_back(phi);
+    ssa->phiBlock[phi] = b;
+}
+
+SSAFunction* buildSSA(TACList& list, TAC* beginFun) {
+    SSAFunction* ssa = new SSAFunction();
+    ssa->list = &list;
+    ssa->cfg = buildCFG(beginFun);
+
+    CFG* cfg = ssa->cfg;
+
+    // Variables of the function, the blocks that define them and the ones that are read in more than one block
+    std::vector<Symbol*> vars;
+    std::map<Symbol*, std::vector<BasicBlock*>> defBlocks;
+    std::set<Symbol*> crossBlock;
+
+    auto addVar = [&](Symbol* sym) {
+        if(defBlocks.count(sym))
+            return;
+
+        vars.push_back(sym);
+        defBlocks[sym];
+
+        // Params and locals are defined by the prologue
+        if(sym->symType != SymbolType::Temp)
+            defBlocks[sym].push_back(cfg->entry());
+    };
+
+    for(BasicBlock* b : cfg->rpo) {
+        std::set<Symbol*> defined;
+
+        for(TAC* t = b->first; t; t = b->next(t)) {
+            for(Symbol* use : tacUses(t)) {
+                if(!isVariable(use))
+                    continue;
+
+                addVar(use);
+                if(!defined.count(use))
+                    crossBlock.insert(use);
+            }
+
+            Symbol* def = tacDef(t);
+            if(isVariable(def)) {
+                addVar(def);
+                defined.insert(def);
+                defBlocks[def].push_back(b);
+            }
+        }
+    }
+
+    // Phis at the iterated dominance frontier, only for the variables that cross blocks (semi-pruned SSA)
+    for(Symbol* var : vars) {
+        if(!crossBlock.count(var))
+            continue;
+
+        std::set<BasicBlock*> hasPhi;
+        std::vector<BasicBlock*> work = defBlocks[var];
+        std::set<BasicBlock*> inWork(work.begin(), work.end());
+
+        while(!work.empty()) {
+            BasicBlock* d = work.back();
+            work.pop_back();
+
+            for(BasicBlock* f : d->domFrontier) {
+                if(f == cfg->exit() || hasPhi.count(f))
+                    continue;
+
+                insertPhi(ssa, f, var);
+                hasPhi.insert(f);
+
+                if(!inWork.count(f)) {
+                    inWork.insert(f);
+                    work.push_back(f);
+                }
+            }
+        }
+    }
+
+    // Renaming, walking the dominator tree
+    std::set<Symbol*> isVar(vars.begin(), vars.end());
+    std::map<Symbol*, std::vector<Symbol*>> stacks;
+    std::map<TAC*, Symbol*> phiVar;
+    std::set<Symbol*> named;
+
+    for(auto& entry : ssa->phis)
+        for(TAC* phi : entry.second)
+            phiVar[phi] = phi->res;
+
+    for(Symbol* var : vars) {
+        if(var->symType == SymbolType::Temp)
+            continue;
+
+        stacks[var].push_back(var);
+        named.insert(var);
+        ssa->original[var] = var;
+        ssa->names.push_back(var);
+        ssa->defs[var] = beginFun;
+    }
+
+    auto newName = [&](Symbol* var, TAC* def) {
+        Symbol* name = named.count(var) ? makeVersion(var) : var;
+        named.insert(name);
+        ssa->original[name] = var;
+        ssa->names.push_back(name);
+        ssa->defs[name] = def;
+        stacks[var].push_back(name);
+        return name;
+    };
+
+    // (block, variables pushed by it), the block is done when it shows up again
+    std::vector<std::pair<BasicBlock*, std::vector<Symbol*>*>> stack = {{cfg->entry(), nullptr}};
+
+    while(!stack.empty()) {
+        BasicBlock* b = stack.back().first;
+        std::vector<Symbol*>* pushed = stack.back().second;
+
+        if(pushed) {
+            for(Symbol* var : *pushed)
+                stacks[var].pop_back();
+
+            delete pushed;
+            stack.pop_back();
+            continue;
+        }
+
+        pushed = new std::vector<Symbol*>();
+        stack.back().second = pushed;
+
+        for(TAC* t = b->first; t; t = b->next(t)) {
+            if(t->type == TACType::PHI) {
+                Symbol* var = phiVar[t];
+                t->res = newName(var, t);
+                pushed->push_back(var);
+                continue;
+            }
+
+            for(Symbol** slot : tacUseSlots(t)) {
+                if(isVar.count(*slot) && !stacks[*slot].empty())
+                    *slot = stacks[*slot].back();
+            }
+
+            Symbol* def = tacDef(t);
+            if(isVar.count(def)) {
+                t->res = newName(def, t);
+                pushed->push_back(def);
+            }
+        }
+
+        for(BasicBlock* s : b->succs) {
+            size_t j = std::find(s->preds.begin(), s->preds.end(), b) - s->preds.begin();
+
+            for(TAC* phi : ssa->phis[s]) {
+                std::vector<Symbol*>& varStack = stacks[phiVar[phi]];
+                phi->args[j] = varStack.empty() ? nullptr : varStack.back();
+            }
+        }
+
+        for(auto it = b->domChildren.rbegin(); it != b->domChildren.rend(); it++)
+            stack.push_back({*it, nullptr});
+    }
+
+    return ssa;
+}
+
+std::map<Symbol*, std::vector<TAC*>> ssaUses(SSAFunction* ssa) {
+    std::map<Symbol*, std::vector<TAC*>> uses;
+
+    for(BasicBlock* b : ssa->cfg->rpo) {
+        for(TAC* t = b->first; t; t = b->next(t)) {
+            if(ssa->isDeleted(t))
+                continue;
+
+            for(Symbol* use : tacUses(t))
+                if(ssa->isSSAName(use))
+                    uses[use].push_back(t);
+        }
+    }
+
+    return uses;
+}
+
+// --- Out of SSA ---
+
+struct Coalescer {
+    std::map<Symbol*, Symbol*> parent;
+    std::map<Symbol*, std::vector<Symbol*>> members;
+    std::map<Symbol*, std::set<Symbol*>> interference;
+
+    Symbol* find(Symbol* sym) {
+        auto it = parent.find(sym);
+        if(it == parent.end()) {
+            parent[sym] = sym;
+            members[sym] = {sym};
+            return sym;
+        }
+
+        if(it->second == sym)
+            return sym;
+
+        return it->second = find(it->second);
+    }
+
+    void interfere(Symbol* a, Symbol* b) {
+        interference[a].insert(b);
+        interference[b].insert(a);
+    }
+
+    bool tryUnion(Symbol* a, Symbol* b) {
+        a = find(a);
+        b = find(b);
+        if(a == b)
+            return true;
+
+        for(Symbol* x : members[a]) {
+            std::set<Symbol*>& edges = interference[x];
+            for(Symbol* y : members[b])
+                if(edges.count(y))
+                    return false;
+        }
+
+        if(members[a].size() < members[b].size())
+            std::swap(a, b);
+
+        parent[b] = a;
+        members[a].insert(members[a].end(), members[b].begin(), members[b].end());
+        members.erase(b);
+        return true;
+    }
+};
+
+static void buildInterference(SSAFunction* ssa, Coalescer& co) {
+    CFG* cfg = ssa->cfg;
+    std::map<BasicBlock*, std::set<Symbol*>> liveIn, liveOut, use, def, phiDefs;
+
+    for(BasicBlock* b : cfg->rpo) {
+        for(TAC* t = b->first; t; t = b->next(t)) {
+            if(ssa->isDeleted(t))
+                continue;
+
+            if(t->type == TACType::PHI) {
+                phiDefs[b].insert(t->res);
+                continue;
+            }
+
+            for(Symbol* u : tacUses(t))
+                if(ssa->isSSAName(u) && !def[b].count(u))
+                    use[b].insert(u);
+
+            Symbol* d = tacDef(t);
+            if(ssa->isSSAName(d))
+                def[b].insert(d);
+        }
+    }
+
+    bool changed = true;
+    while(changed) {
+        changed = false;
+
+        for(auto it = cfg->rpo.rbegin(); it != cfg->rpo.rend(); it++) {
+            BasicBlock* b = *it;
+            std::set<Symbol*> out;
+
+            for(BasicBlock* s : b->succs) {
+                for(Symbol* sym : liveIn[s])
+                    if(!phiDefs[s].count(sym))
+                        out.insert(sym);
+
+                size_t j = std::find(s->preds.begin(), s->preds.end(), b) - s->preds.begin();
+                for(TAC* phi : ssa->phis[s])
+                    if(!ssa->isDeleted(phi) && ssa->isSSAName(phi->args[j]))
+                        out.insert(phi->args[j]);
+            }
+
+            std::set<Symbol*> in = phiDefs[b];
+            in.insert(use[b].begin(), use[b].end());
+            for(Symbol* sym : out)
+                if(!def[b].count(sym))
+                    in.insert(sym);
+
+            if(out != liveOut[b] || in != liveIn[b]) {
+                liveOut[b] = out;
+                liveIn[b] = in;
+                changed = true;
+            }
+        }
+    }
+
+    for(BasicBlock* b : cfg->rpo) {
+        std::set<Symbol*> live = liveOut[b];
+        std::vector<TAC*> code;
+
+        for(TAC* t = b->first; t; t = b->next(t))
+            if(!ssa->isDeleted(t) && t->type != TACType::PHI)
+                code.push_back(t);
+
+        for(auto it = code.rbegin(); it != code.rend(); it++) {
+            TAC* t = *it;
+            Symbol* d = tacDef(t);
+
+            if(ssa->isSSAName(d)) {
+                // A copy doesn't make the two names interfere, they hold the same value
+                for(Symbol* l : live)
+                    if(l != d && !(t->type == TACType::MOVE && l == t->op1))
+                        co.interfere(d, l);
+
+                live.erase(d);
+            }
+
+            for(Symbol* u : tacUses(t))
+                if(ssa->isSSAName(u))
+                    live.insert(u);
+        }
+
+        // The phis are written together when entering the block
+        for(TAC* phi : ssa->phis[b]) {
+            if(ssa->isDeleted(phi))
+                continue;
+
+            live.insert(phi->res);
+        }
+
+        for(TAC* phi : ssa->phis[b]) {
+            if(ssa->isDeleted(phi))
+                continue;
+
+            for(Symbol* l : live)
+                if(l != phi->res)
+                    co.interfere(phi->res, l);
+        }
+
+        // The prologue sets every param and local at once, the ones whose value is dead too: two of them in the
+        // same class would get both initial values in one variable
+        if(b == cfg->entry()) {
+            for(Symbol* name : ssa->names)
+                if(ssa->original[name] == name)
+                    live.insert(name);
+
+            for(Symbol* x : live)
+                for(Symbol* y : live)
+                    if(x < y)
+                        co.interfere(x, y);
+        }
+    }
+}
+
+// Emits the parallel copy as a sequence of MOVEs, breaking the cycles with a temp
+static std::vector<TAC*> sequentializeCopies(std::vector<std::pair<Symbol*, Symbol*>> pending) {
+    std::vector<TAC*> code;
+
+    while(!pending.empty()) {
+        bool emitted = false;
+
+        for(size_t i = 0; i < pending.size(); i++) {
+            Symbol* dst = pending[i].first;
+            bool isSource = false;
+
+            for(size_t j = 0; j < pending.size(); j++)
+                if(j != i && pending[j].second == dst)
+                    isSource = true;
+
+            if(!isSource) {
+                code.push_back(new TAC(TACType::MOVE, dst, pending[i].second));
+                pending.erase(pending.begin() + i);
+                emitted = true;
+                break;
+            }
+        }
+
+        if(emitted)
+            continue;
+
+        // Only cycles are left, save one of the destinations
+        Symbol* dst = pending[0].first;
+        Symbol* tmp = makeTemp();
+        tmp->dataType = dst->dataType;
+        code.push_back(new TAC(TACType::MOVE, tmp, dst));
+
+        for(auto& copy : pending)
+            if(copy.second == dst)
+                copy.second = tmp;
+    }
+
+    return code;
+}
+
+void destroySSA(SSAFunction* ssa) {
+    CFG* cfg = ssa->cfg;
+    TACList& list = *ssa->list;
+
+    // Dead phis would still be written by the copies, so they go first
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        std::map<Symbol*, std::vector<TAC*>> uses = ssaUses(ssa);
+
+        for(auto& entry : ssa->phis) {
+            for(TAC* phi : entry.second) {
+                if(ssa->isDeleted(phi))
+                    continue;
+
+                bool used = false;
+                for(TAC* user : uses[phi->res])
+                    if(user != phi)
+                        used = true;
+
+                if(!used) {
+                    ssa->deleted.insert(phi);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    Coalescer co;
+    buildInterference(ssa, co);
+
+    // The unions are greedy, so they go in the order of the blocks and of the names and not in the order of
+    // the addresses, which depends on where the allocator put them
+    for(BasicBlock* b : cfg->blocks) {
+        if(!b->reachable() || !ssa->phis.count(b))
+            continue;
+
+        for(TAC* phi : ssa->phis[b]) {
+            if(ssa->isDeleted(phi))
+                continue;
+
+            for(size_t j = 0; j < phi->args.size(); j++)
+                if(b->preds[j]->reachable() && ssa->isSSAName(phi->args[j]))
+                    co.tryUnion(phi->res, phi->args[j]);
+        }
+    }
+
+    for(BasicBlock* b : cfg->rpo)
+        for(TAC* t = b->first; t; t = b->next(t))
+            if(!ssa->isDeleted(t) && t->type == TACType::MOVE && ssa->isSSAName(t->res) && ssa->isSSAName(t->op1))
+                co.tryUnion(t->res, t->op1);
+
+    for(Symbol* name : ssa->names)
+        co.tryUnion(ssa->original[name], name);
+
+    // Each class is named after a variable of the source when possible
+    std::map<Symbol*, Symbol*> classRep;
+    for(Symbol* name : ssa->names) {
+        Symbol* root = co.find(name);
+        Symbol*& rep = classRep[root];
+
+        if(!rep || (ssa->original[name] == name && ssa->original[rep] != rep))
+            rep = name;
+    }
+
+    auto rename = [&](Symbol* sym) -> Symbol* {
+        if(!ssa->isSSAName(sym))
+            return sym;
+        return classRep[co.find(sym)];
+    };
+
+    // Versions of params and locals that are left need their own stack slot
+    for(Symbol* name : ssa->names) {
+        Symbol* rep = classRep[co.find(name)];
+        if(rep == name && ssa->original[rep] != rep && rep->symType == SymbolType::Local)
+            cfg->func->extraLocals.push_back(rep);
+    }
+
+    for(TAC* t = cfg->entry()->first; t; t = t->next) {
+        for(Symbol** slot : tacUseSlots(t))
+            *slot = rename(*slot);
+
+        if(t->type == TACType::PHI || tacDef(t))
+            t->res = rename(t->res);
+
+        if(t->type == TACType::ENDFUN)
+            break;
+    }
+
+    // Phis become copies at the end of the predecessors
+    TAC* endFun = cfg->exit()->first;
+    Symbol* exitLabel = nullptr;
+
+    for(BasicBlock* s : cfg->blocks) {
+        if(!s->reachable() || !ssa->phis.count(s))
+            continue;
+
+        for(size_t j = 0; j < s->preds.size(); j++) {
+            BasicBlock* p = s->preds[j];
+            if(!p->reachable())
+                continue;
+
+            std::vector<std::pair<Symbol*, Symbol*>> copies;
+            for(TAC* phi : ssa->phis[s]) {
+                if(ssa->isDeleted(phi) || !phi->args[j] || phi->args[j] == phi->res)
+                    continue;
+
+                copies.push_back({phi->res, phi->args[j]});
+            }
+
+            if(copies.empty())
+                continue;
+
+            std::vector<TAC*> code = sequentializeCopies(copies);
+            TAC* last = p->last;
+
+            if(last->type == TACType::JUMP) {
+                for(TAC* c : code)
+                    tacInsertBefore(list, last, c);
+            } else if(last->type == TACType::IFZ && last->res == s->first->res && p->next(last) == nullptr && last->next == s->first) {
+                // Jumps to the block that comes right after it, both ways reach s
+                Symbol* cond = last->op1;
+                for(TAC* c : code) {
+                    if(c->res == cond) {
+                        Symbol* saved = makeTemp();
+                        saved->dataType = cond->dataType;
+                        tacInsertBefore(list, last, new TAC(TACType::MOVE, saved, cond));
+                        last->op1 = saved;
+                        break;
+                    }
+                }
+
+                for(TAC* c : code)
+                    tacInsertBefore(list, last, c);
+            } else if(last->type == TACType::IFZ && last->res == s->first->res) {
+                // Critical edge, the copies go to a new block at the end of the function
+                if(!exitLabel) {
+                    TAC* beforeEnd = endFun->prev;
+                    exitLabel = makeLabel();
+
+                    if(beforeEnd->type != TACType::JUMP && beforeEnd->type != TACType::RET)
+                        tacInsertBefore(list, endFun, new TAC(TACType::JUMP, exitLabel));
+
+                    tacInsertBefore(list, endFun, new TAC(TACType::LABEL, exitLabel));
+                }
+
+                TAC* exitLabelTac = endFun->prev;
+                Symbol* split = makeLabel();
+
+                tacInsertBefore(list, exitLabelTac, new TAC(TACType::LABEL, split));
+                for(TAC* c : code)
+                    tacInsertBefore(list, exitLabelTac, c);
+                tacInsertBefore(list, exitLabelTac, new TAC(TACType::JUMP, s->first->res));
+
+                last->res = split;
+            } else {
+                // Falls through into s
+                for(auto it = code.rbegin(); it != code.rend(); it++)
+                    tacInsertAfter(list, last, *it);
+            }
+        }
+    }
+
+    // Unlinks phis, deleted TACs and copies to themselves
+    TAC* t = cfg->entry()->first;
+    while(t && t != endFun) {
+        TAC* next = t->next;
+
+        if(t->type == TACType::PHI || ssa->isDeleted(t) || (t->type == TACType::MOVE && t->res == t->op1))
+            tacErase(list, t);
+
+        t = next;
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef SSA_COMP
+#define SSA_COMP
+
+#include "../cfg/cfg.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+// A function in SSA form. Temps, params and locals get one name per definition, and the values
+// that meet at a join point go through PHI TACs placed right after the LABEL of the block.
+// Globals stay as they are, since any call may change them
+struct SSAFunction {
+    TACList* list;
+    CFG* cfg;
+
+    std::map<Symbol*, Symbol*> original;    // SSA name -> variable it is a version of
+    std::vector<Symbol*> names;             // Keys of original in the order they were made, what depends on the order walks this
+    std::map<Symbol*, TAC*> defs;           // SSA name -> TAC that defines it (the BEGINFUN for params and locals)
+    std::map<BasicBlock*, std::vector<TAC*>> phis;
+    std::map<TAC*, BasicBlock*> phiBlock;
+    std::set<TAC*> deleted;                 // Removed by the passes, only unlinked from the list by destroySSA
+    std::map<Symbol*, Symbol*> constantGlobals; // Globals that no TAC of the program writes -> their initial value
+
+    SSAFunction() = default;
+    SSAFunction(const SSAFunction&) = delete;
+    SSAFunction& operator=(const SSAFunction&) = delete;
+    ~SSAFunction() { delete cfg; }
+
+    bool isSSAName(Symbol* sym) const { return sym && original.count(sym) > 0; }
+    bool isDeleted(TAC* t) const { return deleted.count(t) > 0; }
+};
+
+// Puts the function that starts at beginFun in SSA form
+SSAFunction* buildSSA(TACList& list, TAC* beginFun);
+
+// Back to normal TACs. Versions that don't interfere are coalesced into a single variable (usually the original one),
+// so only the PHIs whose operands ended up with different names become copies
+void destroySSA(SSAFunction* ssa);
+
+// Sparse passes over the SSA form, they return whether the code changed
+bool ssaConditionalConstantPropagation(SSAFunction* ssa); // Also folds IFZs on constants and removes the blocks left unreachable
+int ssaCopyPropagation(SSAFunction* ssa);   // These two return how many TACs they removed
+int ssaValueNumbering(SSAFunction* ssa);    // Across the dominator tree
+bool ssaDeadCodeElimination(SSAFunction* ssa);
+bool ssaLoopInvariantCodeMotion(SSAFunction* ssa); // Invariant operations and global loads go to the loop preheader
+
+// Def-use chains, the TACs that read each SSA name
+std::map<Symbol*, std::vector<TAC*>> ssaUses(SSAFunction* ssa);
+
+// Runs the SSA pipeline on every function of the list, with the constant globals prepareSSA found in the whole
+// program (constantGlobals of the unit)
+void prepareSSA(const TACList& list);
+void optimizeSSA(TACList& list);
+
+#endif /* SSA_COMP */
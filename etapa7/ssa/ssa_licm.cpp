@@ -0,0 +1,137 @@
+#include "ssa.h"
+
+static bool isHoistable(TAC* t) {
+    switch(t->type) {
+        case TACType::ADD: case TACType::SUB: case TACType::MUL:
+        case TACType::LESS: case TACType::GREATER: case TACType::LESSEQUAL: case TACType::GREATEREQUAL:
+        case TACType::EQUAL: case TACType::NOTEQUAL: case TACType::AND: case TACType::OR:
+        case TACType::NOT: case TACType::LSHIFT: case TACType::RSHIFT:
+            return true;
+
+        // The loop may not run at all, so only divisions that can't trap
+        case TACType::DIV: case TACType::MOD:
+            return t->op2->symType == SymbolType::Integer && t->op2->intValue != 0 && t->op2->intValue != -1;
+
+        default:
+            return false;
+    }
+}
+
+static bool isScalarGlobal(Symbol* sym) {
+    return sym && sym->symType == SymbolType::VarId && !sym->inStack;
+}
+
+// Globals read in the loop that nothing inside it can change get loaded once in the preheader
+static void hoistGlobalLoads(SSAFunction* ssa, Loop* loop, BasicBlock* pre) {
+    std::set<Symbol*> written;
+    std::map<Symbol*, std::vector<TAC*>> reads;
+    std::vector<Symbol*> globals;   // In the order they are first read, the loads come out in it
+
+    for(BasicBlock* b : loop->blocks) {
+        for(TAC* t = b->first; t; t = b->next(t)) {
+            if(ssa->isDeleted(t))
+                continue;
+
+            // Any function may change the globals
+            if(t->type == TACType::CALL)
+                return;
+
+            if(Symbol* def = tacDef(t))
+                written.insert(def);
+
+            for(Symbol* use : tacUses(t)) {
+                if(!isScalarGlobal(use))
+                    continue;
+
+                if(!reads.count(use))
+                    globals.push_back(use);
+
+                reads[use].push_back(t);
+            }
+        }
+    }
+
+    for(Symbol* global : globals) {
+        if(written.count(global))
+            continue;
+
+        Symbol* value = makeTemp();
+        value->dataType = global->dataType;
+
+        TAC* load = new TAC(TACType::MOVE, value, global);
+        appendToBlock(*ssa->list, pre, load);
+        ssa->original[value] = value;
+        ssa->names.push_back(value);
+        ssa->defs[value] = load;
+
+        for(TAC* t : reads[global])
+            for(Symbol** slot : tacUseSlots(t))
+                if(*slot == global)
+                    *slot = value;
+    }
+}
+
+bool ssaLoopInvariantCodeMotion(SSAFunction* ssa) {
+    CFG* cfg = ssa->cfg;
+    bool changed = false;
+
+    // Inner loops first, what leaves them can still leave the outer ones later
+    for(Loop* loop : cfg->loops) {
+        if(!loop->header->reachable())
+            continue;
+
+        BasicBlock* pre = getPreheader(cfg, loop, *ssa->list);
+        if(!pre)
+            continue;
+
+        size_t hoistedBefore = ssa->defs.size();
+        hoistGlobalLoads(ssa, loop, pre);
+
+        std::set<BasicBlock*> inLoop(loop->blocks.begin(), loop->blocks.end());
+        std::set<TAC*> loopCode;
+        for(BasicBlock* b : loop->blocks)
+            for(TAC* t = b->first; t; t = b->next(t))
+                loopCode.insert(t);
+
+        auto isInvariant = [&](Symbol* sym) {
+            if(ssa->isSSAName(sym))
+                return !loopCode.count(ssa->defs[sym]);
+
+            return !isScalarGlobal(sym) && sym->symType != SymbolType::VecId;
+        };
+
+        bool found = true;
+        while(found) {
+            found = false;
+
+            for(BasicBlock* b : cfg->rpo) {
+                if(!inLoop.count(b))
+                    continue;
+
+                for(TAC* t = b->first; t; t = b->next(t)) {
+                    if(ssa->isDeleted(t) || !ssa->isSSAName(t->res) || !isHoistable(t))
+                        continue;
+
+                    bool invariant = true;
+                    for(Symbol* use : tacUses(t))
+                        invariant &= isInvariant(use);
+
+                    if(!invariant)
+                        continue;
+
+                    // The copy in the preheader takes over the SSA name, the original is dropped with the deleted TACs
+                    TAC* copy = new TAC(t->type, t->res, t->op1, t->op2);
+                    appendToBlock(*ssa->list, pre, copy);
+                    ssa->defs[t->res] = copy;
+                    ssa->deleted.insert(t);
+
+                    found = changed = true;
+                }
+            }
+        }
+
+        changed |= ssa->defs.size() != hoistedBefore;
+    }
+
+    return changed;
+}
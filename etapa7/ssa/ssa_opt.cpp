@@ -0,0 +1,673 @@
+#include "ssa.h"
+#include "../passes/passes.h"
+#include "../context/context.h"
+
+#include <climits>
+#include <tuple>
+
+static void replaceAllUses(SSAFunction* ssa, std::map<Symbol*, std::vector<TAC*>>& uses, Symbol* from, Symbol* to) {
+    for(TAC* t : uses[from]) {
+        for(Symbol** slot : tacUseSlots(t))
+            if(*slot == from)
+                *slot = to;
+
+        if(ssa->isSSAName(to))
+            uses[to].push_back(t);
+    }
+
+    uses[from].clear();
+}
+
+static bool isPureOp(TACType type) {
+    switch(type) {
+        case TACType::ADD: case TACType::SUB: case TACType::MUL: case TACType::DIV: case TACType::MOD:
+        case TACType::LESS: case TACType::GREATER: case TACType::LESSEQUAL: case TACType::GREATEREQUAL:
+        case TACType::EQUAL: case TACType::NOTEQUAL: case TACType::AND: case TACType::OR:
+        case TACType::NOT: case TACType::LSHIFT: case TACType::RSHIFT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// TACs that only compute their result, they can go away when nobody reads it
+static bool isRemovable(SSAFunction* ssa, TAC* t) {
+    if(!ssa->isSSAName(t->res))
+        return false;
+
+    return isPureOp(t->type) || t->type == TACType::MOVE || t->type == TACType::VECACCESS || t->type == TACType::PHI;
+}
+
+// --- Constant propagation ---
+
+enum class LatticeKind { Top, Constant, Bottom };
+
+struct LatticeValue {
+    LatticeKind kind = LatticeKind::Top;
+    int value = 0;
+
+    bool operator!=(const LatticeValue& other) const {
+        return kind != other.kind || (kind == LatticeKind::Constant && value != other.value);
+    }
+};
+
+static LatticeValue constant(int value) { return {LatticeKind::Constant, value}; }
+static LatticeValue bottom() { return {LatticeKind::Bottom, 0}; }
+
+static bool tracksConstants(Symbol* sym) {
+    return sym->dataType == DataType::Int || sym->dataType == DataType::Bool;
+}
+
+// Folds with the same semantics as the generated code: 32 bit wraparound and division truncating to zero
+static bool foldOp(TACType type, int a, int b, int& res) {
+    unsigned ua = static_cast<unsigned>(a), ub = static_cast<unsigned>(b);
+
+    switch(type) {
+        case TACType::ADD: res = static_cast<int>(ua + ub); return true;
+        case TACType::SUB: res = static_cast<int>(ua - ub); return true;
+        case TACType::MUL: res = static_cast<int>(ua * ub); return true;
+        case TACType::DIV:
+            if(b == 0 || (a == INT_MIN && b == -1)) return false;
+            res = a / b; return true;
+        case TACType::MOD:
+            if(b == 0 || (a == INT_MIN && b == -1)) return false;
+            res = a % b; return true;
+        case TACType::LSHIFT: res = static_cast<int>(ua << (b & 31)); return true;
+        case TACType::RSHIFT: res = a >> (b & 31); return true;
+        case TACType::LESS: res = a < b; return true;
+        case TACType::GREATER: res = a > b; return true;
+        case TACType::LESSEQUAL: res = a <= b; return true;
+        case TACType::GREATEREQUAL: res = a >= b; return true;
+        case TACType::EQUAL: res = a == b; return true;
+        case TACType::NOTEQUAL: res = a != b; return true;
+        case TACType::AND: res = a != 0 && b != 0; return true;
+        case TACType::OR: res = a != 0 || b != 0; return true;
+        default: return false;
+    }
+}
+
+static LatticeValue literalValue(Symbol* sym) {
+    if(sym->symType == SymbolType::Integer || sym->symType == SymbolType::Bool)
+        return constant(sym->intValue);
+
+    return bottom();
+}
+
+// Wegman and Zadeck, "Constant Propagation with Conditional Branches". Only the edges that can be taken
+// with the values known so far are followed, so an IFZ on a constant keeps the other side out of the phis
+struct SCCP {
+    SSAFunction* ssa;
+    std::map<Symbol*, std::vector<TAC*>> uses;
+    std::map<Symbol*, LatticeValue> lattice;
+    std::map<TAC*, BasicBlock*> blockOf;
+    std::map<Symbol*, BasicBlock*> labelBlock;
+
+    std::set<BasicBlock*> executable;
+    std::set<std::pair<BasicBlock*, BasicBlock*>> executableEdges;
+    std::vector<std::pair<BasicBlock*, BasicBlock*>> flowWork;
+    std::vector<TAC*> ssaWork;
+
+    SCCP(SSAFunction* ssa);
+
+    LatticeValue operand(Symbol* sym);
+    LatticeValue evaluate(TAC* t);
+    TAC* terminator(BasicBlock* b);
+    void visit(TAC* t);
+    void solve();
+};
+
+SCCP::SCCP(SSAFunction* ssa) : ssa(ssa), uses(ssaUses(ssa)) {
+    const AST& ast = context().ast;
+
+    for(BasicBlock* b : ssa->cfg->blocks) {
+        for(TAC* t = b->first; t; t = b->next(t))
+            blockOf[t] = b;
+
+        if(b->first->type == TACType::LABEL)
+            labelBlock[b->first->res] = b;
+    }
+
+    for(auto& entry : ssa->defs) {
+        Symbol* name = entry.first;
+        if(entry.second->type != TACType::BEGINFUN)
+            continue;
+
+        // Locals start with the value of their declaration, params are unknown
+        Symbol* init = (name->symType == SymbolType::Local && name->value != NoNode) ? ast.symbol[name->value] : nullptr;
+        lattice[name] = (init && tracksConstants(name)) ? literalValue(init) : bottom();
+    }
+}
+
+LatticeValue SCCP::operand(Symbol* sym) {
+    if(ssa->isSSAName(sym))
+        return lattice[sym];
+
+    auto it = ssa->constantGlobals.find(sym);
+    if(it != ssa->constantGlobals.end())
+        return literalValue(it->second);
+
+    return literalValue(sym);
+}
+
+LatticeValue SCCP::evaluate(TAC* t) {
+    if(!tracksConstants(t->res))
+        return bottom();
+
+    switch(t->type) {
+        case TACType::PHI: {
+            BasicBlock* b = ssa->phiBlock[t];
+            LatticeValue res;
+
+            for(size_t j = 0; j < t->args.size(); j++) {
+                if(!t->args[j] || !executableEdges.count({b->preds[j], b}))
+                    continue;
+
+                LatticeValue arg = operand(t->args[j]);
+                if(arg.kind == LatticeKind::Top)
+                    continue;
+                if(arg.kind == LatticeKind::Bottom || (res.kind == LatticeKind::Constant && res.value != arg.value))
+                    return bottom();
+
+                res = arg;
+            }
+
+            return res;
+        }
+
+        case TACType::MOVE:
+            return operand(t->op1);
+
+        case TACType::NOT: {
+            LatticeValue op = operand(t->op1);
+            if(op.kind != LatticeKind::Constant)
+                return op;
+            return constant(op.value == 0);
+        }
+
+        default:
+            break;
+    }
+
+    if(!isPureOp(t->type))
+        return bottom();
+
+    LatticeValue a = operand(t->op1);
+    LatticeValue b = operand(t->op2);
+
+    if(a.kind == LatticeKind::Bottom || b.kind == LatticeKind::Bottom)
+        return bottom();
+    if(a.kind == LatticeKind::Top || b.kind == LatticeKind::Top)
+        return LatticeValue();
+
+    int res;
+    if(!foldOp(t->type, a.value, b.value, res))
+        return bottom();
+
+    return constant(res);
+}
+
+// Last TAC of the block that is still there, nullptr if everything was removed
+TAC* SCCP::terminator(BasicBlock* b) {
+    TAC* last = nullptr;
+
+    for(TAC* t = b->first; t; t = b->next(t))
+        if(!ssa->isDeleted(t))
+            last = t;
+
+    return last;
+}
+
+void SCCP::visit(TAC* t) {
+    BasicBlock* b = blockOf[t];
+    Symbol* def = t->type == TACType::PHI ? t->res : tacDef(t);
+
+    if(ssa->isSSAName(def)) {
+        LatticeValue value = evaluate(t);
+        if(value != lattice[def]) {
+            lattice[def] = value;
+            ssaWork.insert(ssaWork.end(), uses[def].begin(), uses[def].end());
+        }
+    }
+
+    if(t != terminator(b))
+        return;
+
+    BasicBlock* fallthrough = b == ssa->cfg->exit() ? nullptr : ssa->cfg->blocks[b->id + 1];
+
+    switch(t->type) {
+        case TACType::JUMP:
+            flowWork.push_back({b, labelBlock[t->res]});
+            break;
+
+        case TACType::IFZ: {
+            LatticeValue cond = operand(t->op1);
+            if(cond.kind == LatticeKind::Top)
+                break;
+
+            if(cond.kind == LatticeKind::Bottom || cond.value == 0)
+                flowWork.push_back({b, labelBlock[t->res]});
+            if(cond.kind == LatticeKind::Bottom || cond.value != 0)
+                flowWork.push_back({b, fallthrough});
+            break;
+        }
+
+        case TACType::RET:
+            flowWork.push_back({b, ssa->cfg->exit()});
+            break;
+
+        case TACType::ENDFUN:
+            break;
+
+        default:
+            flowWork.push_back({b, fallthrough});
+            break;
+    }
+}
+
+void SCCP::solve() {
+    flowWork.push_back({nullptr, ssa->cfg->entry()});
+
+    while(!flowWork.empty() || !ssaWork.empty()) {
+        while(!flowWork.empty()) {
+            BasicBlock* p = flowWork.back().first;
+            BasicBlock* b = flowWork.back().second;
+            flowWork.pop_back();
+
+            if(!b || executableEdges.count({p, b}))
+                continue;
+
+            executableEdges.insert({p, b});
+
+            if(executable.insert(b).second) {
+                bool empty = true;
+                for(TAC* t = b->first; t; t = b->next(t)) {
+                    if(ssa->isDeleted(t))
+                        continue;
+
+                    visit(t);
+                    empty = false;
+                }
+
+                if(empty)
+                    flowWork.push_back({b, ssa->cfg->blocks[b->id + 1]});
+            } else {
+                for(TAC* phi : ssa->phis[b])
+                    if(!ssa->isDeleted(phi))
+                        visit(phi);
+            }
+        }
+
+        while(!ssaWork.empty()) {
+            TAC* t = ssaWork.back();
+            ssaWork.pop_back();
+
+            if(executable.count(blockOf[t]))
+                visit(t);
+        }
+    }
+}
+
+bool ssaConditionalConstantPropagation(SSAFunction* ssa) {
+    SCCP sccp(ssa);
+    sccp.solve();
+
+    bool changed = false;
+    std::set<TAC*> touched;
+
+    for(auto& entry : sccp.lattice) {
+        Symbol* name = entry.first;
+        if(entry.second.kind != LatticeKind::Constant)
+            continue;
+
+        // Phi operands keep the name, a literal there would only turn into a copy on the edge
+        Symbol* literal = makeLiteral(entry.second.value, name->dataType);
+        std::vector<TAC*> phiUsers;
+
+        for(TAC* user : sccp.uses[name]) {
+            if(user->type == TACType::PHI) {
+                phiUsers.push_back(user);
+                continue;
+            }
+
+            for(Symbol** slot : tacUseSlots(user))
+                if(*slot == name)
+                    *slot = literal;
+
+            touched.insert(user);
+            changed = true;
+        }
+
+        sccp.uses[name] = phiUsers;
+    }
+
+    for(BasicBlock* b : ssa->cfg->blocks) {
+        if(!sccp.executable.count(b)) {
+            // Nothing reaches it anymore
+            if(b == ssa->cfg->entry() || b == ssa->cfg->exit())
+                continue;
+
+            for(TAC* t = b->first; t; t = b->next(t))
+                if(ssa->deleted.insert(t).second)
+                    changed = true;
+
+            continue;
+        }
+
+        for(TAC* t = b->first; t; t = b->next(t)) {
+            if(ssa->isDeleted(t))
+                continue;
+
+            if(t->type == TACType::PHI) {
+                for(size_t j = 0; j < t->args.size(); j++) {
+                    if(t->args[j] && !sccp.executableEdges.count({b->preds[j], b})) {
+                        t->args[j] = nullptr;
+                        changed = true;
+                    }
+                }
+
+                continue;
+            }
+
+            for(Symbol** slot : tacUseSlots(t)) {
+                auto it = ssa->constantGlobals.find(*slot);
+                if(it != ssa->constantGlobals.end()) {
+                    *slot = it->second;
+                    touched.insert(t);
+                    changed = true;
+                }
+            }
+
+            // The branch always goes the same way
+            if(t->type == TACType::IFZ) {
+                LatticeValue cond = sccp.operand(t->op1);
+                if(cond.kind != LatticeKind::Constant)
+                    continue;
+
+                if(cond.value == 0) {
+                    t->type = TACType::JUMP;
+                    t->op1 = nullptr;
+                } else {
+                    ssa->deleted.insert(t);
+                }
+
+                changed = true;
+            }
+        }
+    }
+
+    // Operations that only read constants now, like the ones writing to globals, are folded in place
+    for(TAC* t : touched) {
+        if(ssa->isDeleted(t) || !isPureOp(t->type) || t->type == TACType::NOT || !t->res || !tracksConstants(t->res))
+            continue;
+
+        LatticeValue a = literalValue(t->op1), b = literalValue(t->op2);
+        int res;
+
+        if(a.kind == LatticeKind::Constant && b.kind == LatticeKind::Constant && foldOp(t->type, a.value, b.value, res)) {
+            t->type = TACType::MOVE;
+            t->op1 = makeLiteral(res, t->res->dataType);
+            t->op2 = nullptr;
+        } else {
+            TACConstantFold(t);
+        }
+    }
+
+    return changed;
+}
+
+// --- Copy propagation ---
+
+int ssaCopyPropagation(SSAFunction* ssa) {
+    std::map<Symbol*, std::vector<TAC*>> uses = ssaUses(ssa);
+    int removed = 0;
+
+    for(BasicBlock* b : ssa->cfg->rpo) {
+        for(TAC* t = b->first; t; t = b->next(t)) {
+            if(ssa->isDeleted(t) || t->type != TACType::MOVE || !ssa->isSSAName(t->res) || !ssa->isSSAName(t->op1))
+                continue;
+
+            // A char copied into an int still has to be printed as an int
+            if(t->res->dataType != t->op1->dataType)
+                continue;
+
+            replaceAllUses(ssa, uses, t->res, t->op1);
+            ssa->deleted.insert(t);
+            removed++;
+        }
+    }
+
+    return removed;
+}
+
+// --- Value numbering ---
+
+typedef std::tuple<TACType, Symbol*, Symbol*> ValueKey;
+
+static bool isCommutative(TACType type) {
+    return type == TACType::ADD || type == TACType::MUL || type == TACType::EQUAL || type == TACType::NOTEQUAL ||
+           type == TACType::AND || type == TACType::OR;
+}
+
+// Operands that live in memory (globals and vectors) may change between two equal operations
+static bool readsMemory(SSAFunction* ssa, TAC* t) {
+    if(t->type == TACType::VECACCESS)
+        return true;
+
+    for(Symbol* use : tacUses(t))
+        if(!ssa->isSSAName(use) && use->symType != SymbolType::Integer && use->symType != SymbolType::Char &&
+           use->symType != SymbolType::Bool)
+            return true;
+
+    return false;
+}
+
+// Stores, reads, calls and writes to a global change what is in memory
+static bool writesMemory(SSAFunction* ssa, TAC* t) {
+    if(t->type == TACType::MOVEVEC || t->type == TACType::CALL || t->type == TACType::READ)
+        return true;
+
+    Symbol* def = tacDef(t);
+    return def && !ssa->isSSAName(def);
+}
+
+// An operation already computed in a dominating block is dropped and its uses read the first result.
+// Operations that read memory are only reused inside their block, up to the next write to memory
+int ssaValueNumbering(SSAFunction* ssa) {
+    std::map<Symbol*, std::vector<TAC*>> uses = ssaUses(ssa);
+    std::map<ValueKey, Symbol*> available;
+    std::map<BasicBlock*, std::vector<ValueKey>> added;
+    int removed = 0;
+
+    // Preorder of the dominator tree, the values of a block leave the table once its subtree is done
+    std::vector<std::pair<BasicBlock*, bool>> stack = {{ssa->cfg->blocks[0], false}};
+
+    while(!stack.empty()) {
+        BasicBlock* b = stack.back().first;
+        bool done = stack.back().second;
+        stack.pop_back();
+
+        if(done) {
+            for(const ValueKey& key : added[b])
+                available.erase(key);
+            continue;
+        }
+
+        std::map<ValueKey, Symbol*> memory;
+
+        for(TAC* t = b->first; t; t = b->next(t)) {
+            if(ssa->isDeleted(t))
+                continue;
+
+            if(writesMemory(ssa, t)) {
+                memory.clear();
+                continue;
+            }
+
+            if((!isPureOp(t->type) && t->type != TACType::VECACCESS) || !ssa->isSSAName(t->res))
+                continue;
+
+            Symbol* x = t->op1;
+            Symbol* y = t->op2;
+            if(isCommutative(t->type) && y && std::less<Symbol*>()(y, x))
+                std::swap(x, y);
+
+            ValueKey key = std::make_tuple(t->type, x, y);
+            bool local = readsMemory(ssa, t);
+            std::map<ValueKey, Symbol*>& table = local ? memory : available;
+            auto it = table.find(key);
+
+            if(it == table.end()) {
+                table[key] = t->res;
+                if(!local)
+                    added[b].push_back(key);
+                continue;
+            }
+
+            if(it->second->dataType != t->res->dataType)
+                continue;
+
+            replaceAllUses(ssa, uses, t->res, it->second);
+            ssa->deleted.insert(t);
+            removed++;
+        }
+
+        stack.push_back({b, true});
+        for(BasicBlock* child : b->domChildren)
+            stack.push_back({child, false});
+    }
+
+    return removed;
+}
+
+// --- Dead code elimination ---
+
+bool ssaDeadCodeElimination(SSAFunction* ssa) {
+    std::set<TAC*> live;
+    std::vector<TAC*> work;
+
+    for(BasicBlock* b : ssa->cfg->rpo) {
+        for(TAC* t = b->first; t; t = b->next(t)) {
+            if(ssa->isDeleted(t) || isRemovable(ssa, t))
+                continue;
+
+            live.insert(t);
+            work.push_back(t);
+        }
+    }
+
+    while(!work.empty()) {
+        TAC* t = work.back();
+        work.pop_back();
+
+        for(Symbol* use : tacUses(t)) {
+            if(!ssa->isSSAName(use))
+                continue;
+
+            TAC* def = ssa->defs[use];
+            if(def && !live.count(def)) {
+                live.insert(def);
+                work.push_back(def);
+            }
+        }
+    }
+
+    bool changed = false;
+
+    for(BasicBlock* b : ssa->cfg->rpo) {
+        for(TAC* t = b->first; t; t = b->next(t)) {
+            if(ssa->isDeleted(t) || live.count(t))
+                continue;
+
+            ssa->deleted.insert(t);
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+// Scalar globals that are never assigned keep the literal they were declared with
+static std::map<Symbol*, Symbol*> findConstantGlobals(const TACList& list) {
+    const AST& ast = context().ast;
+    std::set<Symbol*> written;
+    std::map<Symbol*, Symbol*> constants;
+
+    for(TAC* t = list.head; t; t = t->next)
+        if(Symbol* def = tacDef(t))
+            written.insert(def);
+
+    for(Symbol* sym : getAllSymbols()) {
+        if(sym->symType != SymbolType::VarId || sym->inStack || sym->value == NoNode || !ast.symbol[sym->value] || written.count(sym))
+            continue;
+
+        Symbol* init = ast.symbol[sym->value];
+        if(tracksConstants(sym) && (init->symType == SymbolType::Integer || init->symType == SymbolType::Bool))
+            constants[sym] = init;
+    }
+
+    return constants;
+}
+
+void prepareSSA(const TACList& list) {
+    context().constantGlobals = findConstantGlobals(list);
+}
+
+static size_t countSSATACs(SSAFunction* ssa) {
+    size_t count = 0;
+
+    for(BasicBlock* b : ssa->cfg->blocks)
+        for(TAC* t = b->first; t; t = b->next(t))
+            count += !ssa->isDeleted(t);
+
+    return count;
+}
+
+void optimizeSSA(TACList& list) {
+    std::vector<TAC*> functions;
+
+    for(TAC* t = list.head; t; t = t->next)
+        if(t->type == TACType::BEGINFUN)
+            functions.push_back(t);
+
+    const PassFlags& passes = context().passes;
+
+    for(TAC* beginFun : functions) {
+        SSAFunction* ssa = buildSSA(list, beginFun);
+        ssa->constantGlobals = context().constantGlobals;
+
+        int copies = 0, redundant = 0;
+
+        // Runs the pass when it is enabled, and counts the TACs of the function around it for --time-passes
+        auto run = [&](const char* name, bool enabled, auto pass) {
+            if(!enabled)
+                return 0;
+
+            PassTimer timer(name, timePasses() ? countSSATACs(ssa) : 0);
+            int result = pass(ssa);
+            timer.stop(timePasses() ? countSSATACs(ssa) : 0);
+            return result;
+        };
+
+        // Each pass may open opportunities for the others, but a few rounds are enough
+        for(int round = 0; round < passes.ssaRounds; round++) {
+            bool changed = false;
+            int before = copies + redundant;
+
+            changed |= run("sccp", passes.sccp, ssaConditionalConstantPropagation);
+            copies += run("copyprop", passes.copyprop, ssaCopyPropagation);
+            redundant += run("gvn", passes.gvn, ssaValueNumbering);
+            changed |= copies + redundant != before;
+            changed |= run("licm", passes.licm, ssaLoopInvariantCodeMotion);
+            changed |= run("ssa-dce", passes.ssaDce, ssaDeadCodeElimination);
+
+            if(!changed)
+                break;
+        }
+
+        output() << "// " << beginFun->res->content << ": " << copies + redundant << " TACs removed by copy propagation ("
+                 << copies << ") and value numbering (" << redundant << ")\n";
+
+        destroySSA(ssa);
+        delete ssa;
+    }
+}
@@ -0,0 +1,101 @@
+#include "interner.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const size_t initialSlots = 1024;
+static const size_t charsPerChunk = 64 * 1024;
+
+StringInterner::StringInterner() : slots(initialSlots, NoString) {}
+
+// FNV-1a
+uint32_t StringInterner::hash(std::string_view text) {
+    uint32_t h = 2166136261u;
+
+    for(unsigned char c : text) {
+        h ^= c;
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+size_t StringInterner::slotOf(std::string_view text, uint32_t h) const {
+    size_t mask = slots.size() - 1;
+    size_t slot = h & mask;
+
+    while(slots[slot] != NoString) {
+        StringId id = slots[slot];
+        if(hashes[id] == h && strings[id] == text)
+            break;
+
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+StringId StringInterner::find(std::string_view text) const {
+    return slots[slotOf(text, hash(text))];
+}
+
+StringId StringInterner::intern(std::string_view text) {
+    uint32_t h = hash(text);
+    size_t slot = slotOf(text, h);
+
+    if(slots[slot] != NoString)
+        return slots[slot];
+
+    StringId id = strings.size();
+    strings.push_back(store(text));
+    hashes.push_back(h);
+    slots[slot] = id;
+
+    // Keeps the load factor under 1/2, so the probe sequences stay short
+    if(strings.size() * 2 > slots.size())
+        grow();
+
+    return id;
+}
+
+std::string_view StringInterner::store(std::string_view text) {
+    if(text.empty())
+        return std::string_view();
+
+    // Strings bigger than a chunk get one of their own
+    if(chunks.empty() || chunkUsed + text.size() > chunkSize) {
+        chunkSize = std::max(charsPerChunk, text.size());
+        chunks.emplace_back(new char[chunkSize]);
+        chunkUsed = 0;
+    }
+
+    char* copy = chunks.back().get() + chunkUsed;
+    std::memcpy(copy, text.data(), text.size());
+    chunkUsed += text.size();
+
+    return std::string_view(copy, text.size());
+}
+
+void StringInterner::grow() {
+    std::vector<StringId> old(slots.size() * 2, NoString);
+    slots.swap(old);
+
+    size_t mask = slots.size() - 1;
+
+    for(StringId id = 0; id < strings.size(); id++) {
+        size_t slot = hashes[id] & mask;
+        while(slots[slot] != NoString)
+            slot = (slot + 1) & mask;
+
+        slots[slot] = id;
+    }
+}
+
+void StringInterner::clear() {
+    slots.assign(initialSlots, NoString);
+    strings.clear();
+    hashes.clear();
+    chunks.clear();
+    chunkUsed = 0;
+    chunkSize = 0;
+}
@@ -0,0 +1,42 @@
+#ifndef COMP_INTERNER
+#define COMP_INTERNER
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+typedef uint32_t StringId;
+const StringId NoString = UINT32_MAX;
+
+// Gives each distinct string a dense id, starting at 0. The characters are copied into chunks that never move,
+// so the views returned by text() stay valid until clear(). Lookup is an open addressing table with linear probing
+class StringInterner {
+    public:
+        StringInterner();
+
+        StringId intern(std::string_view text);
+        StringId find(std::string_view text) const;     // NoString when text was never interned
+
+        std::string_view text(StringId id) const { return strings[id]; }
+        size_t size() const { return strings.size(); }
+
+        void clear();
+
+    private:
+        static uint32_t hash(std::string_view text);
+
+        size_t slotOf(std::string_view text, uint32_t h) const;  // Slot holding text, or the empty slot where it goes
+        std::string_view store(std::string_view text);
+        void grow();
+
+        std::vector<StringId> slots;            // Power of two size, NoString when empty
+        std::vector<std::string_view> strings;  // By id
+        std::vector<uint32_t> hashes;           // By id, so growing doesn't hash again
+
+        std::vector<std::unique_ptr<char[]>> chunks;
+        size_t chunkUsed = 0;
+        size_t chunkSize = 0;
+};
+
+#endif /* COMP_INTERNER */
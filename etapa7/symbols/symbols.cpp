@@ -2,28 +2,82 @@
 // Aluno: Breno da Silva Morais - 00335794
 
 #include "symbols.h"
+#include "../context/context.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
 #include <iostream>
+#include <unordered_map>
 
-std::map<std::string, Symbol*> SymbolsTable;
+// The table and the arena are in the CompilationContext of the unit (context/context.h),
+// while a function is optimized or emitted the arena is the one of the function
+void* Symbol::operator new(size_t size) {
+    FunctionContext* function = currentFunction();
+    return (function ? function->symbolArena : context().symbolArena).allocate();
+}
+
+// Back to the arena that allocated it. Symbols are only freed when their constructor throws, by the thread making them
+void Symbol::operator delete(void* p) {
+    if(p)
+        Arena<Symbol>::ownerOf(p)->deallocate(p);
+}
+
+// Literals are parsed only here, everything after works with intValue and floatValue
+static void parseLiteral(Symbol* symbol) {
+    const std::string& text = symbol->content;
+
+    switch(symbol->symType) {
+        case SymbolType::Integer: {
+            long long value = 0;
+            std::from_chars(text.data(), text.data() + text.size(), value);
+            symbol->intValue = static_cast<int>(value);
+            break;
+        }
+
+        case SymbolType::Char:
+            symbol->intValue = static_cast<int>(text[1]);   // 'c'
+            break;
+
+        case SymbolType::Bool:
+            symbol->intValue = text == "true";
+            break;
+
+        case SymbolType::Float:
+            symbol->floatValue = std::strtof(text.c_str(), nullptr);
+            break;
+
+        default:
+            break;
+    }
+}
+
+// insertSymbolIntoTable with ctx.symbolsLock already held
+static Symbol* insertSymbolLocked(CompilationContext& ctx, std::string_view text, SymbolType token) {
+    StringId id = ctx.names.intern(text);
 
-Symbol* insertSymbolIntoTable(char* text, SymbolType token) {
-    std::string symbol = std::string(text);
+    if(id == ctx.symbolsTable.size())
+        ctx.symbolsTable.push_back(nullptr);
 
-    auto it = SymbolsTable.find(symbol);
-    if(it != SymbolsTable.end())
-        return it->second;
+    if(!ctx.symbolsTable[id]) {
+        ctx.symbolsTable[id] = new Symbol{token, std::string(text)};
+        parseLiteral(ctx.symbolsTable[id]);
+    }
+
+    return ctx.symbolsTable[id];
+}
 
-    SymbolsTable[symbol] = new Symbol{token, symbol};
-    return SymbolsTable[symbol];
+Symbol* insertSymbolIntoTable(std::string_view text, SymbolType token) {
+    CompilationContext& ctx = context();
+    std::lock_guard<std::mutex> guard(ctx.symbolsLock);
+    return insertSymbolLocked(ctx, text, token);
 }
 
-Symbol* getSymbolFromTable(std::string cont) {
-    auto it = SymbolsTable.find(cont);
-    if(it != SymbolsTable.end())
-        return it->second;
-    
-    return nullptr;
+Symbol* getSymbolFromTable(std::string_view cont) {
+    CompilationContext& ctx = context();
+    std::lock_guard<std::mutex> guard(ctx.symbolsLock);
+    StringId id = ctx.names.find(cont);
+    return id == NoString ? nullptr : ctx.symbolsTable[id];
 }
 
 static std::string getSTypeString(const SymbolType& value) {
@@ -73,28 +127,117 @@ std::ostream& operator<<(std::ostream& out, const DataType& value) {
 
 void printSymbolsTable() {
     std::cout << "Symbol Table:\n";
-    for (const auto& entry : SymbolsTable) {
-        std::cout << "  [" << entry.first
-                  << ", " << entry.second->symType << "]\n";
+    for (Symbol* symbol : getAllSymbols()) {
+        std::cout << "  [" << symbol->content
+                  << ", " << symbol->symType << "]\n";
+    }
+}
+
+static std::string generatedName(Symbol* symbol, Symbol* versionOf) {
+    CompilationContext& ctx = context();
+
+    if(versionOf)
+        return versionOf->content + "." + std::to_string(ctx.versionCount++);
+
+    if(symbol->symType == SymbolType::Temp)
+        return "__temp" + std::to_string(ctx.tempCount++);
+
+    return "__label" + std::to_string(ctx.labelCount++);
+}
+
+// Numbered symbols made by the compiler, outside the table. Inside a function they keep a name of the function
+// until nameGeneratedSymbols, nothing looks at it before that
+static Symbol* makeGenerated(SymbolType type, Symbol* versionOf) {
+    Symbol* symbol = new Symbol{type};
+    FunctionContext* function = currentFunction();
+
+    if(function) {
+        symbol->content = "__new" + std::to_string(function->generated.size());
+        function->generated.push_back(GeneratedSymbol{symbol, versionOf});
+    } else {
+        symbol->content = generatedName(symbol, versionOf);
+        context().generated.push_back(symbol);
     }
+
+    return symbol;
 }
 
 Symbol* makeTemp() {
-    static int tempCount = 0;
-    std::string tempName = "__temp" + std::to_string(tempCount++);
-    return insertSymbolIntoTable(const_cast<char*>(tempName.c_str()), SymbolType::Temp);
+    return makeGenerated(SymbolType::Temp, nullptr);
 }
 
 Symbol* makeLabel() {
-    static int tempCount = 0;
-    std::string tempName = "__label" + std::to_string(tempCount++);
-    return insertSymbolIntoTable(const_cast<char*>(tempName.c_str()), SymbolType::Label);
+    return makeGenerated(SymbolType::Label, nullptr);
+}
+
+// New SSA name for a temp, param or local variable
+Symbol* makeVersion(Symbol* sym) {
+    Symbol* version = makeGenerated(sym->symType == SymbolType::Temp ? SymbolType::Temp : SymbolType::Local, sym);
+    version->dataType = sym->dataType;
+    version->inStack = sym->inStack;
+
+    return version;
+}
+
+// Same numbers they would get with the functions done one after the other. The version of a symbol made in the
+// same function comes after it, so it is named when its name is already the right one
+void nameGeneratedSymbols() {
+    CompilationContext& ctx = context();
+
+    for(auto& function : ctx.functions) {
+        for(GeneratedSymbol& made : function->generated) {
+            made.symbol->content = generatedName(made.symbol, made.versionOf);
+            ctx.generated.push_back(made.symbol);
+        }
+
+        function->generated.clear();
+    }
+}
+
+// Literal holding value, as a bool literal when type is Bool. The functions running at the same time may make the
+// same literal, so the lookup, the insertion and the type are done under one lock: no thread sees it without its type
+Symbol* makeLiteral(int value, DataType type) {
+    CompilationContext& ctx = context();
+    std::lock_guard<std::mutex> guard(ctx.symbolsLock);
+    Symbol* lit;
+
+    if(type == DataType::Bool) {
+        lit = insertSymbolLocked(ctx, value ? "true" : "false", SymbolType::Bool);
+    } else {
+        auto it = ctx.integerLiterals.find(value);
+        if(it != ctx.integerLiterals.end())
+            return it->second;
+
+        lit = insertSymbolLocked(ctx, std::to_string(value), SymbolType::Integer);
+        ctx.integerLiterals[value] = lit;
+    }
+
+    if(lit->dataType == DataType::None)
+        lit->dataType = (type == DataType::Bool) ? DataType::Bool : DataType::Int;
+
+    return lit;
 }
 
-std::map<std::string, Symbol*>& getSymbolTable() {
-    return SymbolsTable;
+std::vector<Symbol*> getAllSymbols() {
+    CompilationContext& ctx = context();
+    std::lock_guard<std::mutex> guard(ctx.symbolsLock);
+    std::vector<Symbol*> all;
+    all.reserve(ctx.symbolsTable.size() + ctx.generated.size());
+
+    for(Symbol* symbol : ctx.symbolsTable)
+        if(symbol)
+            all.push_back(symbol);
+
+    all.insert(all.end(), ctx.generated.begin(), ctx.generated.end());
+
+    std::sort(all.begin(), all.end(), [](Symbol* a, Symbol* b) { return a->content < b->content; });
+    return all;
 }
 
-void removeFromSymbolTable(std::string text) {
-    SymbolsTable.erase(text);
+void removeFromSymbolTable(std::string_view text) {
+    CompilationContext& ctx = context();
+    std::lock_guard<std::mutex> guard(ctx.symbolsLock);
+    StringId id = ctx.names.find(text);
+    if(id != NoString)
+        ctx.symbolsTable[id] = nullptr;
 }
\ No newline at end of file
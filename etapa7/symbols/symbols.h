@@ -2,11 +2,14 @@
 #define COMP_SYM
 
 #include <string>
+#include <string_view>
 #include <stdint.h>
 #include <vector>
 #include <map>
 
-class ASTNode;
+// Index of a node in the AST (ast/ast.h)
+typedef uint32_t ASTNodeId;
+const ASTNodeId NoNode = UINT32_MAX;
 
 enum class SymbolType: uint16_t {
     Identifier,
@@ -40,12 +43,20 @@ struct Symbol {
     std::string label;
     
     // Used by variables, points to their initial value (LIT)
-    ASTNode* value;
+    ASTNodeId value = NoNode;
+
+    // Used by literals, the value of content parsed when the symbol is created.
+    // Integer, Char (its code) and Bool (0 or 1) use intValue, Float uses floatValue
+    int intValue = 0;
+    float floatValue = 0;
 
     //Used in functions
     std::vector<Symbol*> params;
     bool inStack = false; // If the symbol is being stored in the stack (arg or local var)
 
+    // Used in functions, stack variables created by the optimizer (they have no initial value)
+    std::vector<Symbol*> extraLocals;
+
     int getParamIndex(Symbol* sym) {
         for (size_t i = 0; i < params.size(); ++i) {
             if (params[i] == sym) {
@@ -55,15 +66,30 @@ struct Symbol {
         
         return -1;
     }
+
+    // Temps, params and local variables, the values that only exist inside one function
+    bool isFunctionScoped() const {
+        if(symType == SymbolType::Temp)
+            return true;
+
+        return (symType == SymbolType::Local || symType == SymbolType::VarId) && inStack;
+    }
+
+    // From the symbol arena
+    static void* operator new(size_t size);
+    static void operator delete(void* p);
 };
 
-Symbol* insertSymbolIntoTable(char* text, SymbolType type);
-Symbol* getSymbolFromTable(std::string cont);
-std::map<std::string, Symbol*>& getSymbolTable();
+Symbol* insertSymbolIntoTable(std::string_view text, SymbolType type);
+Symbol* getSymbolFromTable(std::string_view cont);
+std::vector<Symbol*> getAllSymbols(); // Table and generated symbols (temps, labels, versions), ordered by name
 void printSymbolsTable();
 Symbol* makeTemp();
 Symbol* makeLabel();
-void removeFromSymbolTable(std::string text);
+Symbol* makeVersion(Symbol* sym);
+void nameGeneratedSymbols();    // Names the symbols the functions made (context/context.h), in source order
+Symbol* makeLiteral(int value, DataType type);  // Integer or Bool literal with that value
+void removeFromSymbolTable(std::string_view text);
 
 std::ostream& operator<<(std::ostream& out, const SymbolType& value);
 std::ostream& operator<<(std::ostream& out, const DataType& value);
@@ -1,10 +1,14 @@
 #include "tacs.h"
+#include "../passes/passes.h"
+#include "../context/context.h"
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <map>
 #include <algorithm>
 
-std::map<ASTNodeType, TACType> ASTtoTAC = {
+// Read only, the units compiled at the same time share these two
+static const std::map<ASTNodeType, TACType> ASTtoTAC = {
     // OPS
     {ASTNodeType::OpAdd, TACType::ADD},
     {ASTNodeType::OpSub, TACType::SUB},
@@ -21,7 +25,7 @@ std::map<ASTNodeType, TACType> ASTtoTAC = {
     {ASTNodeType::OpNotEqual, TACType::NOTEQUAL},
 };
 
-std::map<TACType, DataType> tacDefaultType = {
+static const std::map<TACType, DataType> tacDefaultType = {
     {TACType::ADD, DataType::Int },
     {TACType::SUB, DataType::Int },
     {TACType::MUL, DataType::Int },
@@ -50,143 +54,368 @@ std::map<TACType, DataType> tacDefaultType = {
     {TACType::RET, DataType::None },	
     {TACType::PRINT, DataType::None },	
     {TACType::READ, DataType::None },
+    {TACType::PHI, DataType::None },
 };
 
+// From the arena of the unit (context/context.h), or of the function being worked on
+void* TAC::operator new(size_t size) {
+    FunctionContext* function = currentFunction();
+    return (function ? function->tacArena : context().tacArena).allocate();
+}
+
+// The optimizations of a function erase TACs the unit made (its code before it was split out), the unit arena is
+// shared by the functions running at the same time, so those TACs are only abandoned
+void TAC::operator delete(void* p) {
+    if(!p)
+        return;
+
+    FunctionContext* function = currentFunction();
+    Arena<TAC>& arena = function ? function->tacArena : context().tacArena;
+
+    if(Arena<TAC>::ownerOf(p) == &arena)
+        arena.deallocate(p);
+    else
+        Arena<TAC>::abandon(p);
+}
+
 TAC::TAC(TACType type, Symbol* res, Symbol* op1, Symbol* op2)
             : type(type), res(res), op1(op1), op2(op2), prev(nullptr), next(nullptr) {
                 prev=next=nullptr;
 
-                if(res && res->dataType == DataType::None)
-                    res->dataType = tacDefaultType[type];
+                if(res && res->dataType == DataType::None) {
+                    auto it = tacDefaultType.find(type);
+                    res->dataType = it != tacDefaultType.end() ? it->second : DataType::None;
+                }
             }
 
+std::string tacToString(TAC* t) {
+    if(!t) return "";
+
+    std::ostringstream oss;
+    oss << t->type << " ";
+    if(t->res) oss << t->res->content << " ";
+    if(t->op1) oss << t->op1->content << " ";
+    if(t->op2) oss << t->op2->content << " ";
+    for(Symbol* arg : t->args) oss << (arg ? arg->content : "?") << " ";
+
+    return oss.str();
+}
+
 void tacPrint(TAC* t) {
     if(!t) return;
     // if(t->type == TACType::SYMBOL) return;
 
-    if(t->type != TACType::LABEL) std::cout << "                ";
+    std::ostream& out = output();
+    if(t->type != TACType::LABEL) out << "                ";
 
-    std::cout << t->type << " ";
-    if(t->res) std::cout << t->res->content << " ";
-    if(t->op1) std::cout << t->op1->content << " ";
-    if(t->op2) std::cout << t->op2->content << " ";
-    std::cout << std::endl;
+    out << tacToString(t) << std::endl;
 }
 
-// l must point to the bottom of the list, it will print from the top though
-void tacPrintList(TAC* l) {
-    if(l) {
-        tacPrintList(l->prev);
-        tacPrint(l);
-    }
+void tacPrintList(const TACList& l) {
+    for(TAC* t = l.head; t != nullptr; t = t->next)
+        tacPrint(t);
 }
 
-TAC* tacJoin(TAC* l1, TAC* l2) {
-    
-    if(!l1) return l2;
-    if(!l2) return l1;
-    
-    TAC* t;
-    for(t=l2; t->prev; t = t->prev);
+TACList tacJoin(TACList l1, TACList l2) {
+    if(l1.empty()) return l2;
+    if(l2.empty()) return l1;
 
-    t->prev = l1;
-    l1->next = t;
-    
-    return l2;
+    l1.tail->next = l2.head;
+    l2.head->prev = l1.tail;
+
+    return TACList(l1.head, l2.tail);
+}
+
+void tacAppend(TACList& l, TAC* t) {
+    l = tacJoin(l, TACList(t));
+}
+
+void tacInsertAfter(TACList& l, TAC* pos, TAC* t) {
+    t->prev = pos;
+    t->next = pos->next;
+
+    if(pos->next)
+        pos->next->prev = t;
+    else
+        l.tail = t;
+
+    pos->next = t;
+}
+
+void tacInsertBefore(TACList& l, TAC* pos, TAC* t) {
+    t->next = pos;
+    t->prev = pos->prev;
+
+    if(pos->prev)
+        pos->prev->next = t;
+    else
+        l.head = t;
+
+    pos->prev = t;
 }
 
 /* Retira a TAC t da lista, e retorna a próxima tac*/
-TAC* tacRemove(TAC* t) {
+TAC* tacRemove(TACList& l, TAC* t) {
     if(!t) return nullptr;
 
+    TAC* next = t->next;
+
     if(t->next)
         t->next->prev = t->prev;
+    else
+        l.tail = t->prev;
 
     if(t->prev)
         t->prev->next = t->next;
+    else
+        l.head = t->next;
+
+    t->prev = t->next = nullptr;
+
+    return next;
+}
+
+TAC* tacErase(TACList& l, TAC* t) {
+    TAC* next = tacRemove(l, t);
+    delete t;
+    return next;
+}
 
-    return t->next;
+/* Símbolo escrito pela TAC (nullptr se ela não escreve em nenhum) */
+Symbol* tacDef(TAC* t) {
+    if(!t) return nullptr;
+
+    switch(t->type) {
+        case TACType::MOVEVEC:  // res is the vector, the store goes to memory
+        case TACType::SYMBOL:
+        case TACType::LABEL:
+        case TACType::BEGINFUN:
+        case TACType::ENDFUN:
+        case TACType::IFZ:
+        case TACType::JUMP:
+        case TACType::ARG:
+        case TACType::RET:
+        case TACType::PRINT:
+            return nullptr;
+
+        default:
+            return t->res;
+    }
 }
 
-TAC* generateCode(ASTNode* root) {
-    TAC* result = createTAC(root);
+/* Posições dos operandos lidos pela TAC, para que possam ser trocados */
+std::vector<Symbol**> tacUseSlots(TAC* t) {
+    std::vector<Symbol**> slots;
+    if(!t) return slots;
+
+    switch(t->type) {
+        case TACType::MOVE:
+        case TACType::NOT:
+        case TACType::VECACCESS:    // op2 is the vector base, not a value
+        case TACType::IFZ:
+        case TACType::ARG:          // op2 is the callee's parameter, only used for its index
+            if(t->op1) slots.push_back(&t->op1);
+            break;
+
+        case TACType::RET:
+        case TACType::PRINT:
+            if(t->res) slots.push_back(&t->res);
+            break;
+
+        case TACType::PHI:
+            for(Symbol*& arg : t->args)
+                if(arg) slots.push_back(&arg);
+            break;
+
+        case TACType::SYMBOL:
+        case TACType::LABEL:
+        case TACType::BEGINFUN:
+        case TACType::ENDFUN:
+        case TACType::JUMP:
+        case TACType::CALL:
+        case TACType::READ:
+            break;
+
+        default:
+            if(t->op1) slots.push_back(&t->op1);
+            if(t->op2) slots.push_back(&t->op2);
+            break;
+    }
+
+    return slots;
+}
+
+/* Símbolos lidos pela TAC */
+std::vector<Symbol*> tacUses(TAC* t) {
+    std::vector<Symbol*> uses;
+
+    for(Symbol** slot : tacUseSlots(t))
+        uses.push_back(*slot);
+
+    return uses;
+}
+
+TACList generateCode(ASTNodeId root) {
+    TACList result = createTAC(root);
     
     tacPrintList(result);
-    for(TAC* cur = result; cur != nullptr; cur = cur->prev) {
-        removeAllTacSymbols(cur);   
-        removeRedundancy(cur);
-        removeDeadCode(cur);
-    }
-    std::cout << "\n\n";
+    runPassPipeline(result);
+    *context().out << "\n\n";
     tacPrintList(result);    
 
     return result;
 }
 
-TAC* createTAC(ASTNode* root, Symbol* funcContext, int index) {
-    if(!root) return 0;
+// Símbolo onde fica o resultado do código da lista
+static Symbol* tacResult(const TACList& l) {
+    return l.tail ? l.tail->res : nullptr;
+}
+
+// Comparação que dá o resultado oposto, para desviar quando a original é verdadeira
+static const std::map<ASTNodeType, TACType> invertedComparison = {
+    {ASTNodeType::OpLess, TACType::GREATEREQUAL},
+    {ASTNodeType::OpGreater, TACType::LESSEQUAL},
+    {ASTNodeType::OpLessEqual, TACType::GREATER},
+    {ASTNodeType::OpGreaterEqual, TACType::LESS},
+    {ASTNodeType::OpEqual, TACType::NOTEQUAL},
+    {ASTNodeType::OpNotEqual, TACType::EQUAL},
+};
+
+TACList createCondition(ASTNodeId cond, Symbol* trueLabel, Symbol* falseLabel, Symbol* funcContext) {
+    const AST& ast = context().ast;
+
+    switch(ast.type[cond]) {
+        case ASTNodeType::OpAnd: {
+            // Right side only runs when the left one is true
+            Symbol* skip = falseLabel ? falseLabel : makeLabel();
+            TACList result = tacJoin(
+                createCondition(ast.child(cond, 0), nullptr, skip, funcContext),
+                createCondition(ast.child(cond, 1), trueLabel, falseLabel, funcContext)
+            );
+
+            if(!falseLabel)
+                tacAppend(result, new TAC(TACType::LABEL, skip));
+
+            return result;
+        }
+
+        case ASTNodeType::OpOr: {
+            // Right side only runs when the left one is false
+            Symbol* skip = trueLabel ? trueLabel : makeLabel();
+            TACList result = tacJoin(
+                createCondition(ast.child(cond, 0), skip, nullptr, funcContext),
+                createCondition(ast.child(cond, 1), trueLabel, falseLabel, funcContext)
+            );
+
+            if(!trueLabel)
+                tacAppend(result, new TAC(TACType::LABEL, skip));
+
+            return result;
+        }
 
-    TAC* code[std::max(static_cast<int>(root->children.size()), 4)];
-    TAC* result = nullptr;
+        case ASTNodeType::OpNot:
+            return createCondition(ast.child(cond, 0), falseLabel, trueLabel, funcContext);
 
-    // Needs to be sure that the first 4 positions are null
-    for(size_t i = 0; i < 4; i++) {
-        code[i] = nullptr;
+        default:
+            break;
     }
 
-    for(size_t i = 0; i < root->children.size(); i++) {
-        code[i] = createTAC(
-            root->children[i], 
-            (root->type == ASTNodeType::FuncCall) ? root->symbol: funcContext, 
-            (root->type == ASTNodeType::ArgList) ? index + 1: index
-        );
+    // Jumps when the comparison is true: IFZ on the opposite comparison
+    auto inverted = invertedComparison.find(ast.type[cond]);
+    if(trueLabel && !falseLabel && inverted != invertedComparison.end()) {
+        TACList left = createTAC(ast.child(cond, 0), funcContext);
+        TACList right = createTAC(ast.child(cond, 1), funcContext);
+        TAC* compare = new TAC(inverted->second, makeTemp(), tacResult(left), tacResult(right));
+
+        return tacJoin(tacJoin(tacJoin(left, right), compare), new TAC(TACType::IFZ, trueLabel, compare->res));
     }
 
-    switch(root->type) {
+    TACList code = createTAC(cond, funcContext);
+    Symbol* value = tacResult(code);
+
+    if(!trueLabel)
+        return tacJoin(code, new TAC(TACType::IFZ, falseLabel, value));
+
+    if(falseLabel)
+        return tacJoin(tacJoin(code, new TAC(TACType::IFZ, falseLabel, value)), new TAC(TACType::JUMP, trueLabel));
+
+    Symbol* skip = makeLabel();
+    return tacJoin(tacJoin(tacJoin(
+        code,
+        new TAC(TACType::IFZ, skip, value)),
+        new TAC(TACType::JUMP, trueLabel)),
+        new TAC(TACType::LABEL, skip)
+    );
+}
+
+TACList createTAC(ASTNodeId root, Symbol* funcContext) {
+    if(root == NoNode) return TACList();
+
+    const AST& ast = context().ast;
+    ASTChildren children = ast.children(root);
+    ASTNodeType type = ast.type[root];
+    Symbol* symbol = ast.symbol[root];
+
+    // Empty lists by default, so the first 4 positions can always be used
+    std::vector<TACList> code(std::max<size_t>(children.size(), 4));
+    TACList result;
+
+    // The condition of ifs and whiles is generated as jumps by createCondition
+    bool isBranch = type == ASTNodeType::CmdIf || type == ASTNodeType::CmdIfElse || type == ASTNodeType::CmdWhile;
+
+    for(size_t i = 0; i < children.size(); i++) {
+        if(isBranch && i == 0)
+            continue;
+
+        code[i] = createTAC(children[i], (type == ASTNodeType::FuncCall) ? symbol : funcContext);
+    }
+
+    switch(type) {
         case ASTNodeType::Unknown:
-            std::cout << "Unknown AST Node in TAC Generation\n";
+            output() << "Unknown AST Node in TAC Generation\n";
             break;
 
         case ASTNodeType::Lit:
         case ASTNodeType::Identifier:
-            result = new TAC(TACType::SYMBOL, root->symbol);
+            result = new TAC(TACType::SYMBOL, symbol);
             break;
 
         case ASTNodeType::DecFunc:
-            result = tacJoin(tacJoin(tacJoin(tacJoin( new TAC(TACType::BEGINFUN, root->symbol), code[0]), code[1]),  code[2]), new TAC(TACType::ENDFUN, root->symbol) ); 
+            result = tacJoin(tacJoin(tacJoin(tacJoin( new TAC(TACType::BEGINFUN, symbol), code[0]), code[1]),  code[2]), new TAC(TACType::ENDFUN, symbol) ); 
             // Maybe doesn't work because there is trash on the list
             break;
 
         case ASTNodeType::CmdAssign:
-            if(code[0]) {
-                if(code[0]->type == TACType::SYMBOL)
-                    result = tacJoin( code[0], new TAC(TACType::MOVE, root->symbol, code[0]->res));
+            if(!code[0].empty()) {
+                if(code[0].tail->type == TACType::SYMBOL)
+                    result = tacJoin( code[0], new TAC(TACType::MOVE, symbol, tacResult(code[0])));
                 else {
-                    code[0]->res = root->symbol;
+                    code[0].tail->res = symbol;
                     result = code[0];
             }}
 
             break;
 
         case ASTNodeType::CmdArrayElementAssign:
-            result = tacJoin(tacJoin( code[0], code[1]), new TAC(TACType::MOVEVEC, root->symbol, code[0] ? code[0]->res : nullptr, code[1] ? code[1]->res : nullptr));
+            result = tacJoin(tacJoin( code[0], code[1]), new TAC(TACType::MOVEVEC, symbol, tacResult(code[0]), tacResult(code[1])));
             break;
 
         case ASTNodeType::CmdRead:
-            result = new TAC(TACType::READ, root->symbol);
+            result = new TAC(TACType::READ, symbol);
             break;
 
         case ASTNodeType::CmdReturn:
-            result = tacJoin( code[0], new TAC(TACType::RET, code[0] ? code[0]->res : nullptr));
+            result = tacJoin( code[0], new TAC(TACType::RET, tacResult(code[0])));
             break;
 
         case ASTNodeType::PrintList:
-            result = tacJoin(tacJoin(tacJoin(
-                root->symbol ? new TAC(TACType::PRINT, root->symbol) : nullptr,
-                code[0]),
-                (code[0] && code[0]->type != TACType::PRINT) ? new TAC(TACType::PRINT, code[0]->res) : nullptr),
-                code[1]
-                );
+            // Strings are printed as they are, expressions by their result
+            for(size_t i = 0; i < children.size(); i++) {
+                if(ast.type[children[i]] == ASTNodeType::Lit && ast.symbol[children[i]]->symType == SymbolType::String)
+                    result = tacJoin(result, new TAC(TACType::PRINT, ast.symbol[children[i]]));
+                else
+                    result = tacJoin(tacJoin(result, code[i]), new TAC(TACType::PRINT, tacResult(code[i])));
+            }
 
             break;
 
@@ -204,40 +433,32 @@ TAC* createTAC(ASTNode* root, Symbol* funcContext, int index) {
         case ASTNodeType::OpGreaterEqual:
         case ASTNodeType::OpEqual:
         case ASTNodeType::OpNotEqual:
-            result = tacJoin(tacJoin(code[0],code[1]), new TAC(ASTtoTAC[root->type], makeTemp(), code[0] ? code[0]->res : nullptr, code[1] ? code[1]->res : nullptr));
-            result = TACConstantFold(result);
+            result = tacJoin(tacJoin(code[0],code[1]), TACConstantFold(new TAC(ASTtoTAC.at(type), makeTemp(), tacResult(code[0]), tacResult(code[1]))));
             break;
     
         case ASTNodeType::OpNot:
-            result = tacJoin(code[0], new TAC(TACType::NOT, makeTemp(), code[0] ? code[0]->res : nullptr));
+            result = tacJoin(code[0], new TAC(TACType::NOT, makeTemp(), tacResult(code[0])));
             break;
 
         case ASTNodeType::ArrayElement:
-            result = tacJoin(code[0], new TAC(TACType::VECACCESS, makeTemp(), code[0] ? code[0]->res : nullptr, root->symbol));
+            result = tacJoin(code[0], new TAC(TACType::VECACCESS, makeTemp(), tacResult(code[0]), symbol));
             break;
 
         case ASTNodeType::FuncCall:
-            if(root->children.size() > 0) {
-                result = tacJoin(code[0], new TAC(TACType::CALL, makeTemp(), root->symbol));
-            } else {
-                result = new TAC(TACType::CALL, makeTemp(), root->symbol);
-            }
+            result = tacJoin(code[0], new TAC(TACType::CALL, makeTemp(), symbol));
             break;
 
         case ASTNodeType::ArgList:
-            result = tacJoin(tacJoin(
-                    code[0],
-                    new TAC(TACType::ARG, funcContext, code[0]->res, funcContext->params[index])),
-                    code[1]
-                );
-                
+            // funcContext is the function being called, each argument goes to its parameter
+            for(size_t i = 0; i < children.size(); i++)
+                result = tacJoin(tacJoin(result, code[i]), new TAC(TACType::ARG, funcContext, tacResult(code[i]), funcContext->params[i]));
+
             break;
 
         case ASTNodeType::CmdIf: {
             Symbol* label = makeLabel();
-            result = tacJoin(tacJoin(tacJoin(
-                code[0],                                                            // if condition
-                new TAC(TACType::IFZ, label, code[0] ? code[0]->res : nullptr)),    // jump to label
+            result = tacJoin(tacJoin(
+                createCondition(children[0], nullptr, label, funcContext),    // if condition, jumps to label when false
                 code[1]),                                                           // block
                 new TAC(TACType::LABEL, label)                                      // label
             );
@@ -247,9 +468,8 @@ TAC* createTAC(ASTNode* root, Symbol* funcContext, int index) {
         case ASTNodeType::CmdIfElse: {
             Symbol* label1 = makeLabel();
             Symbol* label2 = makeLabel();
-            result = tacJoin(tacJoin(tacJoin(tacJoin(tacJoin(tacJoin(
-                code[0],                                                            // if condition             
-                new TAC(TACType::IFZ, label1, code[0] ? code[0]->res : nullptr)),   // jump to label1
+            result = tacJoin(tacJoin(tacJoin(tacJoin(tacJoin(
+                createCondition(children[0], nullptr, label1, funcContext),   // if condition, jumps to label1 when false
                 code[1]),                                                           // block
                 new TAC(TACType::JUMP, label2)),                                    // JUMP label2
                 new TAC(TACType::LABEL, label1)),                                   // label1
@@ -260,21 +480,22 @@ TAC* createTAC(ASTNode* root, Symbol* funcContext, int index) {
         }
 
         case ASTNodeType::CmdWhile: {
+            // Rotated into do-while: the condition is tested once on the way in and then at the bottom,
+            // so each iteration only takes the branch back to label1
             Symbol* label1 = makeLabel();
             Symbol* label2 = makeLabel();
-            result = tacJoin(tacJoin(tacJoin(tacJoin(tacJoin(
-                new TAC(TACType::LABEL, label1),                                    // label1
-                code[0]),                                                           // if condition
-                new TAC(TACType::IFZ, label2, code[0] ? code[0]->res : nullptr)),   // jump to label2 se 0
+            result = tacJoin(tacJoin(tacJoin(tacJoin(
+                createCondition(children[0], nullptr, label2, funcContext),   // guard, jumps to label2 se 0
+                new TAC(TACType::LABEL, label1)),                                   // label1
                 code[1]),                                                           // block
-                new TAC(TACType::JUMP, label1)),                                    // volta para o início
+                createCondition(children[0], label1, nullptr, funcContext)),  // condition, volta para o início se 1
                 new TAC(TACType::LABEL, label2)                                     // label saida
             );
             break;
         }
 
         default:
-            for(size_t i = 0; i < root->children.size(); i++) {
+            for(size_t i = 0; i < children.size(); i++) {
                 result = tacJoin(result, code[i]);
             }
             break;
@@ -283,52 +504,43 @@ TAC* createTAC(ASTNode* root, Symbol* funcContext, int index) {
     return result;
 }
 
-/* eL: End of list*/
-void removeAllTacSymbols(TAC* eL) {
-    if(!eL) return;
-
-    if(eL->type == TACType::SYMBOL) {
-        tacRemove(eL);
+void removeAllTacSymbols(TACList& list) {
+    for(TAC* t = list.head; t != nullptr;) {
+        if(t->type == TACType::SYMBOL)
+            t = tacErase(list, t);
+        else
+            t = t->next;
     }
-
-    // Talvez tenha um memory leak mas a vida é assim mesmo
 }
 
-void removeDeadCode(TAC* eL) {
-    if(!eL) return;
-
-    if(eL->type == TACType::RET) {
-        for(TAC* dead = eL->next; dead != nullptr; dead = dead->next) {
-            if(dead->type == TACType::ENDFUN || dead->type == TACType::LABEL)
-                break;
+void removeDeadCode(TACList& list) {
+    for(TAC* t = list.head; t != nullptr; t = t->next) {
+        if(t->type != TACType::RET)
+            continue;
 
-            tacRemove(dead);
-        }
+        while(t->next && t->next->type != TACType::ENDFUN && t->next->type != TACType::LABEL)
+            tacErase(list, t->next);
     }
 }
 
-void removeRedundancy(TAC* eL) {
-    if(!eL) return;
-
-    switch(eL->type) {
-        case TACType::JUMP:
-            if(eL->next && eL->next->type == TACType::LABEL && eL->res == eL->next->res) {
-                tacRemove(eL);
-            }
-        
-            break;
+void removeRedundancy(TACList& list) {
+    for(TAC* t = list.head; t != nullptr;) {
+        switch(t->type) {
+            case TACType::JUMP:
+            case TACType::IFZ:
+                if(t->next && t->next->type == TACType::LABEL && t->res == t->next->res) {
+                    t = tacErase(list, t);
+                    continue;
+                }
+            
+                break;
 
-        case TACType::IFZ:
-            if(eL->next && eL->next->type == TACType::LABEL && eL->res == eL->next->res) {
-                tacRemove(eL);
-            }
-        
-            break;
+            default:
+                break;
+        }
 
-        default:
-            break;
+        t = t->next;
     }
-
 }
 
 static int getPowerOfTwo(int n) {
@@ -350,37 +562,41 @@ TAC* TACConstantFold(TAC* t) {
     if (t->op1 && t->op1->symType == SymbolType::Integer && 
         t->op2 && t->op2->symType == SymbolType::Integer) {
 
-        std::string tempName = "";
-        int val1 = std::stoi(t->op1->content);
-        int val2 = std::stoi(t->op2->content);
+        bool folded = true;
+        int result = 0;
+        int val1 = t->op1->intValue;
+        int val2 = t->op2->intValue;
 
         switch (t->type) {
             case TACType::ADD:
-                tempName = std::to_string(val1 + val2);
+                result = val1 + val2;
                 break;
 
             case TACType::SUB:
-                tempName = std::to_string(val1 - val2);
+                result = val1 - val2;
                 break;
 
             case TACType::MUL:
-                tempName = std::to_string(val1 * val2);
+                result = val1 * val2;
                 break;
 
             case TACType::DIV:
-                if(val2 != 0) tempName = std::to_string(static_cast<int>(val1 / val2));
+                if(val2 != 0) result = val1 / val2;
+                else folded = false;
                 break;
 
             case TACType::MOD:
-                if(val2 != 0) tempName = std::to_string(val1 % val2);
+                if(val2 != 0) result = val1 % val2;
+                else folded = false;
                 break;
 
             default:
+                folded = false;
                 break;
         }
 
-        if(tempName != "") {
-            Symbol* newLit = insertSymbolIntoTable(const_cast<char*>(tempName.c_str()), SymbolType::Integer);
+        if(folded) {
+            Symbol* newLit = makeLiteral(result, DataType::Int);
             
             t->type = TACType::MOVE;
             t->op1 = newLit;
@@ -394,7 +610,7 @@ TAC* TACConstantFold(TAC* t) {
     bool op2Lit = (t->op2 && t->op2->symType == SymbolType::Integer);
 
     if (op1Lit || op2Lit) {
-        int val = op1Lit ? std::stoi(t->op1->content) : std::stoi(t->op2->content);
+        int val = op1Lit ? t->op1->intValue : t->op2->intValue;
         Symbol* varSym = op1Lit ? t->op2 : t->op1; // The variable part
 
         // ADD 0, SUB 0, MUL 1, DIV 1
@@ -434,7 +650,7 @@ TAC* TACConstantFold(TAC* t) {
         // x * 0 OR 0 * x -> MOVE 0
         if (t->type == TACType::MUL && val == 0) {
             t->type = TACType::MOVE;
-            t->op1 = insertSymbolIntoTable(const_cast<char*>("0"), SymbolType::Integer);
+            t->op1 = makeLiteral(0, DataType::Int);
             t->op2 = nullptr;
             return t;
         }
@@ -446,18 +662,7 @@ TAC* TACConstantFold(TAC* t) {
         if (t->type == TACType::MUL && power > 0) {
             t->type = TACType::LSHIFT;
             t->op1 = varSym;
-            std::string shiftStr = std::to_string(power);
-            t->op2 = insertSymbolIntoTable(const_cast<char*>(shiftStr.c_str()), SymbolType::Integer);
-            return t;
-        }
-
-        // Division by power of 2
-        // x / 8 -> x >> 3
-        if (t->type == TACType::DIV && power > 0 && !op1Lit) {
-            t->type = TACType::RSHIFT;
-            t->op1 = varSym;
-            std::string shiftStr = std::to_string(power);
-            t->op2 = insertSymbolIntoTable(const_cast<char*>(shiftStr.c_str()), SymbolType::Integer);
+            t->op2 = makeLiteral(power, DataType::Int);
             return t;
         }
     }
@@ -467,7 +672,7 @@ TAC* TACConstantFold(TAC* t) {
 
 
 
-static std::string getTACTypeString(const TACType& value) {
+const std::string& getTACTypeString(const TACType& value) {
     static const std::map<const TACType, std::string> result {
         {TACType::ADD, "ADD"},
         {TACType::SUB, "SUB"},
@@ -499,10 +704,12 @@ static std::string getTACTypeString(const TACType& value) {
         {TACType::RET, "RET"},	
         {TACType::PRINT, "PRINT"},	
         {TACType::READ, "READ"},
+        {TACType::PHI, "PHI"},
     };
     #undef ADD_NAME
+    static const std::string unknown = "Unknown Tac Type";
     auto it = result.find(value);
-    if (it == result.end()) return "Unknown Tac Type";
+    if (it == result.end()) return unknown;
     return it->second;
 };
 
@@ -41,6 +41,8 @@ enum class TACType {
     RET,	
     PRINT,	
     READ,
+
+    PHI,    // Only exists while the function is in SSA form
 };
 
 struct TAC {
@@ -51,24 +53,54 @@ struct TAC {
         Symbol* op2;
         TAC* prev;
         TAC* next;
+        std::vector<Symbol*> args; // PHI operands, one for each predecessor of the block
 
         TAC(TACType type, Symbol* res = nullptr, Symbol* op1 = nullptr, Symbol* op2 = nullptr);
+
+        // From the TAC arena, deleted TACs are reused by the next ones
+        static void* operator new(size_t size);
+        static void operator delete(void* p);
 };
 
+// Handle of a TAC list, keeps both ends so joining, appending and removing are O(1)
+struct TACList {
+    TAC* head = nullptr;
+    TAC* tail = nullptr;
+
+    TACList() = default;
+    TACList(TAC* t) : head(t), tail(t) {}
+    TACList(TAC* head, TAC* tail) : head(head), tail(tail) {}
+
+    bool empty() const { return head == nullptr; }
+};
+
+std::string tacToString(TAC* t);
 void tacPrint(TAC* t);
-void tacPrintList(TAC* l);
-TAC* tacJoin(TAC* l1, TAC* l2);
-TAC* tacRemove(TAC* t);
+void tacPrintList(const TACList& l);
+TACList tacJoin(TACList l1, TACList l2);
+void tacAppend(TACList& l, TAC* t);
+void tacInsertAfter(TACList& l, TAC* pos, TAC* t);
+void tacInsertBefore(TACList& l, TAC* pos, TAC* t);
+TAC* tacRemove(TACList& l, TAC* t);
+TAC* tacErase(TACList& l, TAC* t);    // Removes and frees t, returns the TAC after it
+Symbol* tacDef(TAC* t);
+std::vector<Symbol*> tacUses(TAC* t);
+std::vector<Symbol**> tacUseSlots(TAC* t);
+
+TACList generateCode(ASTNodeId root);
+TACList createTAC(ASTNodeId root, Symbol* funcContext = nullptr);
 
-TAC* generateCode(ASTNode* root);
-TAC* createTAC(ASTNode* root, Symbol* funcContext = nullptr, int index = 0);
+// Jumping code for the condition of ifs and whiles, & and | are short-circuited.
+// Goes to trueLabel/falseLabel, a nullptr label means falling through to the next TAC
+TACList createCondition(ASTNodeId cond, Symbol* trueLabel, Symbol* falseLabel, Symbol* funcContext = nullptr);
 
 // Otim
-void removeAllTacSymbols(TAC* eL);
-void removeDeadCode(TAC* eL);
-void removeRedundancy(TAC* eL);
+void removeAllTacSymbols(TACList& list);
+void removeDeadCode(TACList& list);
+void removeRedundancy(TACList& list);
 TAC* TACConstantFold(TAC* t);
 
+const std::string& getTACTypeString(const TACType& value);
 std::ostream& operator<<(std::ostream& out, const TACType& value);
 
 #endif // TACS_H
\ No newline at end of file
@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# Roda os testes que tem saida esperada (tests/nome.out): compila em -O0 e em -O2, monta com o gcc, executa com
+# tests/nome.in na entrada quando ele existe e compara a saida com a esperada
+status=0
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+for expected in tests/*.out; do
+    f=${expected%.out}
+    input=/dev/null
+    [ -f "$f.in" ] && input=$f.in
+
+    for level in -O0 -O2; do
+        name=$(basename "$f")$level
+
+        if ! ./etapa7 $level "$f" "$dir/$name.s" > /dev/null 2>&1; then
+            echo "nao compila: $f $level"
+            status=1
+        elif ! gcc -no-pie "$dir/$name.s" -o "$dir/$name" 2> /dev/null; then
+            echo "nao monta: $f $level"
+            status=1
+        elif ! diff <("$dir/$name" < "$input" 2>&1) "$expected" > /dev/null; then
+            echo "saida diferente: $f $level"
+            status=1
+        fi
+    done
+done
+exit $status